@@ -0,0 +1,287 @@
+// bench.c - clic.h benchmarks on synthetic schemas
+// make bench (or cc -O2 -o clic-bench bench.c && ./clic-bench > bench.jsonl)
+//
+// Each case declares nb_params parameters (integers, strings and booleans) in
+// the last of nb_subcommands subcommands, the others getting one parameter
+// each, plus a restricted string parameter with nb_options options. argv
+// invokes the last subcommand and sets parameters and options in turn.
+// For each case, one JSON object is printed per line, holding the best of
+// several runs:
+// * declare_ns_per_call: clic_add_* calls (subcommands, parameters, options),
+// * parse_ns_per_token: clic_parse on the declarations,
+// * ctx_parse_ns_per_token: clic_ctx_parse on a compiled context,
+// * help_ns: clic_ctx_render_help for the invoked subcommand,
+// * peak_heap_bytes: heap in use at most from clic_init to clic_parse.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// count the heap used by clic.h, by routing its allocations through wrappers
+// keeping the size of each block in front of it
+union bench_block {
+    max_align_t align;
+    size_t size;
+};
+
+static size_t heap_used, heap_peak;
+
+static void *
+bench_malloc(size_t size)
+{
+    union bench_block *block = malloc(sizeof(*block) + size);
+
+    if (!block) {
+        return NULL;
+    }
+    block->size = size;
+    if ((heap_used += size) > heap_peak) {
+        heap_peak = heap_used;
+    }
+    return block + 1;
+}
+
+static void *
+bench_calloc(size_t nb, size_t size)
+{
+    void *data;
+
+    if (size && nb > SIZE_MAX / size) {
+        return NULL;
+    }
+    if ((data = bench_malloc(nb * size))) {
+        memset(data, 0, nb * size);
+    }
+    return data;
+}
+
+static void
+bench_free(void *data)
+{
+    union bench_block *block = data;
+
+    if (block) {
+        heap_used -= block[-1].size;
+        free(block - 1);
+    }
+}
+
+static void *
+bench_realloc(void *data, size_t size)
+{
+    union bench_block *block = data;
+    void *copy;
+
+    if (!block) {
+        return bench_malloc(size);
+    }
+    if (!(copy = bench_malloc(size))) {
+        return NULL;
+    }
+    memcpy(copy, data, block[-1].size < size ? block[-1].size : size);
+    bench_free(data);
+    return copy;
+}
+
+#define malloc(size)            bench_malloc(size)
+#define calloc(nb, size)        bench_calloc(nb, size)
+#define realloc(data, size)     bench_realloc(data, size)
+#define free(data)              bench_free(data)
+#define CLIC_IMPL
+#include "clic.h"
+#undef malloc
+#undef calloc
+#undef realloc
+#undef free
+
+#define MAX_PARAMS      10000
+#define MAX_SUBCOMMANDS 500
+#define MAX_OPTIONS     1000
+#define NB_SETTINGS     2000    // parameters set by argv
+#define NB_CHOICES      500     // options set by argv, if any
+#define MAX_TOKENS      (2 + 2 * (NB_SETTINGS + NB_CHOICES))
+#define NB_CALLS        300000  // clic_add_* calls per case, roughly
+
+static const size_t nb_params_cases[] = { 10, 100, 1000, 10000 };
+static const size_t nb_subcommands_cases[] = { 1, 20, 500 };
+static const size_t nb_options_cases[] = { 0, 1000 };
+
+static char params[MAX_PARAMS + MAX_SUBCOMMANDS][8];
+static char subcommands[MAX_SUBCOMMANDS][8], options[MAX_OPTIONS][8];
+static char flags[NB_SETTINGS][12], values[NB_SETTINGS][8];
+static int ints[MAX_PARAMS + MAX_SUBCOMMANDS];
+static const char *strings[MAX_PARAMS], *choice;
+
+static void
+name(char *s, char prefix, size_t i)
+{
+    // valid and distinct names: prefix, then i in base 26
+    *s++ = prefix;
+    for (int j = 0; j < 4; j++, i /= 26) {
+        *s++ = 'a' + i % 26;
+    }
+    *s = '\0';
+}
+
+static double
+now(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static size_t
+declare(size_t nb_params, size_t nb_subcommands, size_t nb_options)
+{
+    // returns the number of clic_add_* calls
+    int id = (int) nb_subcommands;
+    size_t i;
+
+    clic_init("bench", "1.0", NULL, "synthetic schema", 0, 0);
+    for (i = 0; i < nb_subcommands; i++) {
+        clic_add_subcommand((int) i + 1, subcommands[i], "subcommand", 0);
+    }
+    for (i = 0; i + 1 < nb_subcommands; i++) {
+        clic_add_param_int((int) i + 1, params[MAX_PARAMS + i], "parameter",
+            0, &ints[MAX_PARAMS + i]);
+    }
+    for (i = 0; i < nb_params; i++) {
+        switch (i % 3) {
+        case 0:
+            clic_add_param_int(id, params[i], "integer", 0, &ints[i]);
+            break;
+        case 1:
+            clic_add_param_string(id, params[i], "string", "", &strings[i],
+                0);
+            break;
+        case 2:
+            clic_add_param_bool(id, params[i], "boolean", 0, &ints[i], 0);
+            break;
+        }
+    }
+    if (nb_options) {
+        clic_add_param_string(id, "choice", "restricted string", options[0],
+            &choice, 1);
+        for (i = 0; i < nb_options; i++) {
+            clic_add_param_string_option(id, "choice", options[i]);
+        }
+    }
+    return nb_subcommands + (nb_subcommands - 1) + nb_params +
+        (nb_options ? 1 + nb_options : 0);
+}
+
+static int
+fill_argv(const char *argv[], size_t nb_params, size_t nb_subcommands,
+    size_t nb_options)
+{
+    // returns argc
+    size_t i, k;
+    int argc = 0;
+
+    argv[argc++] = "bench";
+    argv[argc++] = subcommands[nb_subcommands - 1];
+    for (i = 0; i < NB_SETTINGS; i++) {
+        k = (i * 37) % nb_params;
+        if (k % 3 == 2) {
+            strcat(strcpy(flags[i], i % 2 ? "--no-" : "--"), params[k]);
+            argv[argc++] = flags[i];
+        } else {
+            strcat(strcpy(flags[i], "--"), params[k]);
+            argv[argc++] = flags[i];
+            argv[argc++] = values[i];
+        }
+        if (nb_options && i < NB_CHOICES) {
+            argv[argc++] = "--choice";
+            argv[argc++] = options[(i * 61) % nb_options];
+        }
+    }
+    argv[argc] = NULL;
+    return argc;
+}
+
+static void
+run_case(size_t nb_params, size_t nb_subcommands, size_t nb_options)
+{
+    static const char *argv[MAX_TOKENS + 1];
+    struct clic_ctx ctx;
+    double start, declare_ns = -1, parse_ns = -1, ctx_parse_ns = -1;
+    double help_ns = -1, t;
+    size_t nb_calls, help_bytes = 0, peak = 0;
+    int argc, runs, subcommand_id;
+    char *help;
+
+    argc = fill_argv(argv, nb_params, nb_subcommands, nb_options);
+    nb_calls = nb_subcommands + nb_params + nb_options;
+    runs = NB_CALLS / nb_calls;
+    runs = runs < 3 ? 3 : runs > 100 ? 100 : runs;
+
+    for (int run = 0; run < runs; run++) {
+        // declarations, then parsing through the global API
+        heap_peak = heap_used;
+        start = now();
+        nb_calls = declare(nb_params, nb_subcommands, nb_options);
+        t = (now() - start) / nb_calls;
+        declare_ns = declare_ns < 0 || t < declare_ns ? t : declare_ns;
+        start = now();
+        clic_parse(argc, argv, &subcommand_id);
+        t = (now() - start) / (argc - 1);
+        parse_ns = parse_ns < 0 || t < parse_ns ? t : parse_ns;
+        peak = heap_peak - heap_used;
+
+        // compiled context
+        declare(nb_params, nb_subcommands, nb_options);
+        clic_compile(&ctx);
+        start = now();
+        clic_ctx_parse(&ctx, argc, argv, &subcommand_id);
+        t = (now() - start) / (argc - 1);
+        ctx_parse_ns = ctx_parse_ns < 0 || t < ctx_parse_ns ? t : ctx_parse_ns;
+        start = now();
+        help = clic_ctx_render_help(&ctx, (int) nb_subcommands, &help_bytes);
+        t = now() - start;
+        help_ns = help_ns < 0 || t < help_ns ? t : help_ns;
+        bench_free(help);
+        clic_ctx_free(&ctx);
+    }
+
+    printf("{\"params\": %zu, \"subcommands\": %zu, \"options\": %zu, "
+        "\"tokens\": %d, \"runs\": %d, \"declare_ns_per_call\": %.1f, "
+        "\"parse_ns_per_token\": %.1f, \"ctx_parse_ns_per_token\": %.1f, "
+        "\"help_ns\": %.0f, \"help_bytes\": %zu, \"peak_heap_bytes\": %zu}\n",
+        nb_params, nb_subcommands, nb_options, argc - 1, runs, declare_ns,
+        parse_ns, ctx_parse_ns, help_ns, help_bytes, peak);
+    fflush(stdout);
+}
+
+int
+main(void)
+{
+    size_t i, j, k;
+
+    for (i = 0; i < MAX_PARAMS + MAX_SUBCOMMANDS; i++) {
+        name(params[i], 'p', i);
+    }
+    for (i = 0; i < MAX_SUBCOMMANDS; i++) {
+        name(subcommands[i], 's', i);
+    }
+    for (i = 0; i < MAX_OPTIONS; i++) {
+        name(options[i], 'o', i);
+    }
+    for (i = 0; i < NB_SETTINGS; i++) {
+        snprintf(values[i], sizeof(values[i]), "%zu", i);
+    }
+
+    for (i = 0; i < CLIC_COUNT(nb_params_cases); i++) {
+        for (j = 0; j < CLIC_COUNT(nb_subcommands_cases); j++) {
+            for (k = 0; k < CLIC_COUNT(nb_options_cases); k++) {
+                run_case(nb_params_cases[i], nb_subcommands_cases[j],
+                    nb_options_cases[k]);
+            }
+        }
+    }
+
+    return 0;
+}
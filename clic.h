@@ -24,10 +24,114 @@
 //    after named arguments, returns the number of argv elements read for later
 //    parsing of unnamed arguments)
 
+// Alternatively, steps 1 and 2 can be replaced by static constant tables
+// describing the whole command line interface, handed to `clic_init_static`.
+// Such a schema lives in read-only data, and is indexed once by
+// `clic_init_static`. As it is not checked on the fly like `clic_add_*` calls,
+// it should be validated once with `clic_check_schema`, typically from a test
+// suite. The `CLIC_PARAM_*` and `CLIC_ARG_*` macros build table entries,
+// `CLIC_PARAMS`, `CLIC_ARGS` and `CLIC_SUBCOMMANDS` fill the corresponding
+// fields of scopes and schemas:
+//     static int verbose;
+//     static const char *format;
+//     static const char *const formats[] = {"text", "json"};
+//     static const struct clic_param_or_arg params[] = {
+//         CLIC_PARAM_FLAG("v", "increase verbosity", &verbose, 0),
+//         CLIC_PARAM_STRING_RESTRICTED("format", "output format", "text",
+//             &format, formats),
+//     };
+//     static const struct clic_schema schema = {
+//         .metadata = { .version = "1.0.0", .license = "GPLv3" },
+//         .main_scope = { .name = "demo", CLIC_PARAMS(params) },
+//     };
+// In both cases, variables are assigned their default value by `clic_parse`.
+
+// The functions above share a global state, and are a thin wrapper around a
+// reentrant interface: `clic_ctx_init` prepares a `struct clic_ctx` for a
+// schema (indexing it for fast lookups), `clic_ctx_parse` parses a command
+// line against it and `clic_ctx_free` releases it. Independent contexts can be
+// used concurrently from different threads without locking, as long as they
+// don't share variables. `clic_ctx_render_help` and `clic_ctx_use_help_cache`
+// are the counterparts of the global help functions.
+// A context owns a copy of the schema, and can parse any number of command
+// lines without allocating (list parameters and `--conf` files aside). Each
+// parse only assigns the default values of the main scope and of the invoked
+// subcommand, those of other subcommands being left untouched. `clic_compile`
+// ends a `clic_init`/`clic_add_*` declaration by handing it to a context
+// instead of parsing. To keep results apart (for instance when parsing
+// concurrently with the same context), variables can be declared as members of
+// a prototype structure registered with `clic_ctx_set_results`:
+// `clic_ctx_parse_into` then stores them at the same offsets in the given
+// results structure instead.
+
+// Errors are reported by printing a message and exiting, as are `--help` and
+// `--version` handled. For embedding in long-running programs,
+// `clic_ctx_try_parse` never exits and returns the outcome as a state instead:
+// `CLIC_PARSED`, `CLIC_HELP` (`clic_ctx_render_help` then gives the message),
+// `CLIC_VERSION` or `CLIC_ERROR`. The `struct clic_status` it fills tells the
+// invoked subcommand, the number of argv elements read, and for errors a code,
+// the argv index of the offending token (-1 if there is none) and a message,
+// written in the `message_size` bytes of `message` when it is not NULL.
+
+// Commands received as single lines can be parsed with
+// `clic_ctx_try_parse_line`, which splits a mutable line in place into the
+// caller's `argv` array (of `argv_size` elements, including `argv[0]`, set to
+// the program name, and the terminating NULL) and parses it, without any
+// allocation. The line only holds arguments, split like a shell would: blanks
+// separate tokens, a backslash escapes the next character, single quotes keep
+// their content literal, double quotes allow escaping `"` and `\`, and `#`
+// starts a comment.
+
+// `clic_ctx_validate_batch` parses every record of a file (separated by
+// newlines, or NUL characters) like such a line, skipping blank records and
+// comments, and writes `N: ok` or `N: message` for the Nth record to the
+// report stream (unless it is NULL). It returns the number of invalid records.
+// Records are parsed into scratch copies of the variables, so that neither the
+// declared variables nor the results prototype are modified. Records have at
+// most `CLIC_BATCH_MAX_TOKENS` tokens.
+
+// Help messages are rendered in memory and written at once. `clic_render_help`
+// gives the help message of a scope as a string (to be freed by the caller),
+// and can be called at any time between initialization and parsing.
+
+// All declarations are stored in an arena: a few large blocks are allocated
+// instead of one chunk per declaration, and `clic_parse` releases them at once.
+// Defining `CLIC_ARENA_SIZE` (in bytes) makes clic.h first use a static buffer
+// of that size, so that a program whose declarations fit in it never calls
+// `malloc`. Bigger blocks are then allocated on demand with a size of
+// `CLIC_ARENA_BLOCK_SIZE` bytes.
+
 // Optionnally, the macros `CLIC_DUMP_SYNOPSIS` and `CLIC_DUMP_OPTIONS` can be
-// defined to print out the corresponding manual section and exit on the
-// `clic_parse` call. It should be done with a compiler flag (`-DCLIC_DUMP_*`)
-// rather than in source code.
+// defined to print out the corresponding manual section (in roff, covering all
+// scopes) and exit on the `clic_parse` call. It should be done with a compiler
+// flag (`-DCLIC_DUMP_*`) rather than in source code.
+
+// Similarly, `CLIC_DUMP_HELP_C` makes `clic_parse` print out a C source file
+// holding the rendered help message of every scope, as a `clic_help_texts`
+// array of `clic_nb_help_texts` elements. Once this file is compiled in the
+// program, handing these to `clic_use_help_cache` makes `--help` write the
+// precomputed text instead of rendering it. The cache must be regenerated
+// whenever declarations change, and assumes a fixed program name.
+
+// `CLIC_DUMP_BASH_COMPLETION`, `CLIC_DUMP_ZSH_COMPLETION` and
+// `CLIC_DUMP_FISH_COMPLETION` make `clic_parse` print out a completion script
+// for the corresponding shell, covering subcommands, parameters and the options
+// of restricted strings, so that completion never runs the program:
+//     cc -DCLIC_DUMP_BASH_COMPLETION -o tmp *.c && ./tmp > demo.bash
+// Bash scripts are sourced, zsh ones installed as `_demo` in `$fpath`, and fish
+// ones as `demo.fish` in `~/.config/fish/completions`.
+
+// Completion can also be delegated to the program itself: when invoked as
+// `demo __complete WORDS...` (and no subcommand is named `__complete`),
+// `clic_parse` prints the candidates for the last word, one per line, and
+// exits. Candidates come from a prefix trie of parameters, subcommands and
+// restricted string options, built once per scope by `clic_ctx_init` (or on
+// the fly for the completed scope only), so that a lookup stays well below a
+// millisecond. `clic_ctx_complete` returns the same list as a string. In bash:
+//     _demo() {
+//         COMPREPLY=($(demo __complete "${COMP_WORDS[@]:1:COMP_CWORD}"))
+//     }
+//     complete -o default -F _demo demo
 
 // Each subcommand must be associated with a non-null integer, while 0 refers to
 // the main program scope. These subcommand identifiers are used:
@@ -42,11 +146,57 @@
 // line syntax:
 // - flag: -n
 // - bool: --name, --no-name
-// - int or string: --name value
+// - int, long, int64, uint64, size, double or string: --name value,
+//   --name=value
+// - int list or string list: as int or string, repeated
+// Flags can be bundled (`-abc` for `-a -b -c`). Other parameters with a single
+// character name can also be given as `-n value` or `-nvalue`, possibly at the
+// end of a bundle (`-abj8`).
 // For flags and booleans, a bit mask can be specified. If so, the associated
 // variable will only be modified on the mask bits, allowing to pack multiple
 // flags/booleans in the same variable.
+// Integers are written in decimal, or in hexadecimal with a `0x` prefix, and
+// can be followed by a `k`, `M`, `G` or `T` suffix (binary multiples, so that
+// `4k` is 4096). Values that don't fit in the variable type are rejected.
+// Doubles are written in decimal with an optional exponent (`-1.5`, `2e-3`),
+// whatever the locale, and are correctly rounded.
 // For strings, a list of acceptable values can be specified to restrict input.
+// Lists gather all the values given to a parameter, in order, into an array
+// allocated with `malloc` (NULL when there is none) whose number of elements
+// is stored in a separate count variable. The array belongs to the caller,
+// who releases it with `free(list)` once done (`clic_parse` keeps no pointer
+// to it). Parsing again into the same variables starts new lists, so the
+// previous ones must be freed first, with `free` or `clic_ctx_free_results`.
+
+// Parameters can also be read from a configuration file with `--conf FILE`
+// (unless a `conf` parameter is declared), at the position of this parameter
+// in the command line so that later parameters override the file. Each line is
+// either `name = value`, or a lone `name` (`no-name`) for flags and booleans.
+// Blank lines and lines starting with `#` are ignored. The file is mapped in
+// memory (where `CLIC_MMAP` is available) and, when string variables point
+// directly into it, kept for the whole program lifetime with `clic_parse`, and
+// until `clic_ctx_free_results` is called on the results (or `clic_ctx_free`)
+// with contexts. `clic_parse` accepts `--conf`, contexts only do after
+// `clic_ctx_allow_conf`.
+
+// With an environment prefix (`clic_set_env_prefix`, or the `env_prefix`
+// metadata of static tables), parameters of the invoked scope are also read
+// from environment variables named after them: `MYAPP_` and `dry-run` give
+// `MYAPP_DRY_RUN`. Such values are overridden by the command line, lists only
+// taking their variable's value when the command line gives them none. Flags
+// and booleans take `1`, `true`, `yes` or `on`, or `0`, `false`, `no` or `off`.
+// Messages for invalid values start with the name of the variable.
+// The environment is read from `CLIC_ENVIRON` (`environ` where available), in a
+// single pass as long as it holds at most `CLIC_ENV_MAX_LISTS` list variables.
+
+// With `clic_allow_abbreviations` (or the `allow_abbreviations` metadata of
+// static tables), long parameters and subcommands can also be given by an
+// unambiguous prefix of their name, like `--verb` for `--verbose`. Prefixes are
+// resolved with the completion trie of the scope (see `__complete` above), in
+// time proportional to their length. An ambiguous prefix is an error, except
+// for subcommands when they are optional, the word then being left to the
+// main scope. Tries are built once, by `clic_parse` for declarations, and by
+// `clic_init_static` (which then copies the tables) or `clic_ctx_init`.
 
 // Note: Functions using `const char *` parameters only store the pointer to the
 // data, and don't duplicate it. Therefore, it should be given constant data.
@@ -83,9 +233,191 @@
 #ifndef CLIC_H
 #define CLIC_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+struct clic_index {
+    struct clic_index_slot {
+        const char *name;
+        size_t position;
+    } *slots;
+    size_t capacity, count;
+};
+struct clic_id_index {
+    struct clic_id_index_slot {
+        int subcommand_id;
+        size_t position;
+    } *slots;
+    size_t capacity, count;
+};
+struct clic_trie {
+    struct clic_trie_node {
+        uint32_t child, sibling;    // 0 for none, the root being node 0
+        unsigned char c, is_word;
+        const char *name;           // of words, without namespace or dashes
+    } *nodes;
+    size_t nb_nodes;
+};
+
+struct clic_param_or_arg {
+    const char *name, *description;
+    enum clic_type {
+        CLIC_FLAG,
+        CLIC_BOOL,
+        CLIC_INT,
+        CLIC_STRING,
+        CLIC_LONG,
+        CLIC_INT64,
+        CLIC_UINT64,
+        CLIC_SIZE,
+        CLIC_INT_LIST,
+        CLIC_STRING_LIST,
+        CLIC_DOUBLE,
+    } type;
+    int is_required;
+    union clic_type_specific_data {
+        struct {
+            int scalar_default_value, *scalar_variable, mask;
+        };
+        struct {
+            const char *string_default_value, **string_variable;
+            int restrict_to_declared_options;
+            const char *const *string_options;
+            size_t nb_string_options;
+        };
+        struct {
+            union {
+                int64_t signed_default_value;
+                uint64_t unsigned_default_value;
+            };
+            void *integer_variable;
+        };
+        struct {
+            void *list_variable;    // int ** or const char ***
+            size_t *list_count;
+        };
+        struct {
+            double double_default_value, *double_variable;
+        };
+    } data;
+};
+struct clic_scope {
+    int subcommand_id;
+    const char *name, *description;
+    const struct clic_param_or_arg *params, *args;
+    size_t nb_params, nb_args;
+    int accept_unnamed_arguments;
+    struct clic_index params_index, args_index; // left empty in static tables
+    size_t *short_params;   // position + 1 of single character parameters,
+                            // by character, left empty in static tables
+    struct clic_index env_index;    // by environment variable name, without
+                                    // prefix, left empty in static tables
+    struct clic_trie completions;   // left empty in static tables
+};
+struct clic_schema {
+    struct clic_metadata {
+        const char *version, *license;
+        int require_subcommand;
+        const char *env_prefix;
+        int allow_abbreviations;
+    } metadata;
+    struct clic_scope main_scope;
+    const struct clic_scope *subcommands;
+    size_t nb_subcommands;
+    struct clic_index subcommand_names;     // left empty in static tables
+    struct clic_id_index subcommand_ids;    // left empty in static tables
+};
+
+#define CLIC_COUNT(array)       (sizeof(array) / sizeof(*(array)))
+#define CLIC_PARAMS(array) \
+    .params = (array), .nb_params = CLIC_COUNT(array)
+#define CLIC_ARGS(array) \
+    .args = (array), .nb_args = CLIC_COUNT(array)
+#define CLIC_SUBCOMMANDS(array) \
+    .subcommands = (array), .nb_subcommands = CLIC_COUNT(array)
+
+#define CLIC_PARAM_FLAG(name, description, variable, bit_mask) \
+    { (name), (description), CLIC_FLAG, 0, { \
+        .scalar_variable = (variable), .mask = (bit_mask) } }
+#define CLIC_PARAM_BOOL(name, description, default_value, variable, \
+    bit_mask) \
+    { (name), (description), CLIC_BOOL, 0, { \
+        .scalar_default_value = (default_value), \
+        .scalar_variable = (variable), .mask = (bit_mask) } }
+#define CLIC_PARAM_INT(name, description, default_value, variable) \
+    { (name), (description), CLIC_INT, 0, { \
+        .scalar_default_value = (default_value), \
+        .scalar_variable = (variable) } }
+#define CLIC_PARAM_LONG(name, description, default_value, variable) \
+    { (name), (description), CLIC_LONG, 0, { \
+        .signed_default_value = (default_value), \
+        .integer_variable = (variable) } }
+#define CLIC_PARAM_INT64(name, description, default_value, variable) \
+    { (name), (description), CLIC_INT64, 0, { \
+        .signed_default_value = (default_value), \
+        .integer_variable = (variable) } }
+#define CLIC_PARAM_UINT64(name, description, default_value, variable) \
+    { (name), (description), CLIC_UINT64, 0, { \
+        .unsigned_default_value = (default_value), \
+        .integer_variable = (variable) } }
+#define CLIC_PARAM_SIZE(name, description, default_value, variable) \
+    { (name), (description), CLIC_SIZE, 0, { \
+        .unsigned_default_value = (default_value), \
+        .integer_variable = (variable) } }
+#define CLIC_PARAM_DOUBLE(name, description, default_value, variable) \
+    { (name), (description), CLIC_DOUBLE, 0, { \
+        .double_default_value = (default_value), \
+        .double_variable = (variable) } }
+#define CLIC_PARAM_STRING(name, description, default_value, variable) \
+    { (name), (description), CLIC_STRING, 0, { \
+        .string_default_value = (default_value), \
+        .string_variable = (variable) } }
+#define CLIC_PARAM_STRING_RESTRICTED(name, description, default_value, \
+    variable, options) \
+    { (name), (description), CLIC_STRING, 0, { \
+        .string_default_value = (default_value), \
+        .string_variable = (variable), .restrict_to_declared_options = 1, \
+        .string_options = (options), \
+        .nb_string_options = CLIC_COUNT(options) } }
+#define CLIC_PARAM_INT_LIST(name, description, variable, count) \
+    { (name), (description), CLIC_INT_LIST, 0, { \
+        .list_variable = (variable), .list_count = (count) } }
+#define CLIC_PARAM_STRING_LIST(name, description, variable, count) \
+    { (name), (description), CLIC_STRING_LIST, 0, { \
+        .list_variable = (variable), .list_count = (count) } }
+#define CLIC_ARG_INT(name, description, variable) \
+    { (name), (description), CLIC_INT, 1, { \
+        .scalar_variable = (variable) } }
+#define CLIC_ARG_LONG(name, description, variable) \
+    { (name), (description), CLIC_LONG, 1, { \
+        .integer_variable = (variable) } }
+#define CLIC_ARG_INT64(name, description, variable) \
+    { (name), (description), CLIC_INT64, 1, { \
+        .integer_variable = (variable) } }
+#define CLIC_ARG_UINT64(name, description, variable) \
+    { (name), (description), CLIC_UINT64, 1, { \
+        .integer_variable = (variable) } }
+#define CLIC_ARG_SIZE(name, description, variable) \
+    { (name), (description), CLIC_SIZE, 1, { \
+        .integer_variable = (variable) } }
+#define CLIC_ARG_DOUBLE(name, description, variable) \
+    { (name), (description), CLIC_DOUBLE, 1, { \
+        .double_variable = (variable) } }
+#define CLIC_ARG_STRING(name, description, variable) \
+    { (name), (description), CLIC_STRING, 1, { \
+        .string_variable = (variable) } }
+#define CLIC_ARG_STRING_RESTRICTED(name, description, variable, options) \
+    { (name), (description), CLIC_STRING, 1, { \
+        .string_variable = (variable), .restrict_to_declared_options = 1, \
+        .string_options = (options), \
+        .nb_string_options = CLIC_COUNT(options) } }
+
 void clic_init(const char *program, const char *version, const char *license,
     const char *description, int require_subcommand,
     int accept_unnamed_arguments);
+void clic_set_env_prefix(const char *prefix);
+void clic_allow_abbreviations(void);
 
 void clic_add_subcommand(int subcommand_id, const char *name,
     const char *description, int accept_unnamed_arguments);
@@ -96,33 +428,187 @@ void clic_add_param_bool(int subcommand_id, const char *name,
     const char *description, int default_value, int *variable, int mask);
 void clic_add_param_int(int subcommand_id, const char *name,
     const char *description, int default_value, int *variable);
+void clic_add_param_long(int subcommand_id, const char *name,
+    const char *description, long default_value, long *variable);
+void clic_add_param_int64(int subcommand_id, const char *name,
+    const char *description, int64_t default_value, int64_t *variable);
+void clic_add_param_uint64(int subcommand_id, const char *name,
+    const char *description, uint64_t default_value, uint64_t *variable);
+void clic_add_param_size(int subcommand_id, const char *name,
+    const char *description, size_t default_value, size_t *variable);
+void clic_add_param_double(int subcommand_id, const char *name,
+    const char *description, double default_value, double *variable);
 void clic_add_param_string(int subcommand_id, const char *name,
     const char *description, const char *default_value, const char **variable,
     int restrict_to_declared_options);
+void clic_add_param_int_list(int subcommand_id, const char *name,
+    const char *description, int **variable, size_t *count);
+void clic_add_param_string_list(int subcommand_id, const char *name,
+    const char *description, const char ***variable, size_t *count);
 void clic_add_param_string_option(int subcommand_id, const char *param_name,
     const char *value);
 
 void clic_add_arg_int(int subcommand_id, const char *name,
     const char *description, int *variable);
+void clic_add_arg_long(int subcommand_id, const char *name,
+    const char *description, long *variable);
+void clic_add_arg_int64(int subcommand_id, const char *name,
+    const char *description, int64_t *variable);
+void clic_add_arg_uint64(int subcommand_id, const char *name,
+    const char *description, uint64_t *variable);
+void clic_add_arg_size(int subcommand_id, const char *name,
+    const char *description, size_t *variable);
+void clic_add_arg_double(int subcommand_id, const char *name,
+    const char *description, double *variable);
 void clic_add_arg_string(int subcommand_id, const char *name,
     const char *description, const char **variable,
     int restrict_to_declared_options);
 void clic_add_arg_string_option(int subcommand_id, const char *arg_name,
     const char *value);
 
+void clic_init_static(const struct clic_schema *schema);
+void clic_check_schema(const struct clic_schema *schema);
+
+struct clic_help_text {
+    int subcommand_id;
+    const char *text;
+    size_t length;
+};
+
+extern const struct clic_help_text clic_help_texts[]; // CLIC_DUMP_HELP_C
+extern const size_t clic_nb_help_texts;
+
+char *clic_render_help(int subcommand_id, size_t *length);
+void clic_use_help_cache(const struct clic_help_text *texts, size_t nb);
+
 int clic_parse(int argc, const char *argv[], int *subcommand_id);
 
+struct clic_arena {
+    char *cur, *end;
+    struct clic_arena_block *blocks;
+};
+struct clic_ctx {
+    const struct clic_schema *schema;
+    const char *program_name;
+    const struct clic_help_text *help_texts;
+    size_t nb_help_texts;
+    const char *results_prototype;
+    size_t results_size;
+    int allow_conf;
+    struct clic_arena arena;
+    struct clic_kept_files *kept_files; // that results point into
+};
+
+struct clic_status {
+    enum clic_state {
+        CLIC_PARSED,
+        CLIC_HELP,
+        CLIC_VERSION,
+        CLIC_ERROR,
+    } state;
+    int subcommand_id, nb_processed_arguments;
+    enum clic_error_code {
+        CLIC_ERROR_NONE,
+        CLIC_ERROR_SUBCOMMAND_NOT_FOUND,
+        CLIC_ERROR_UNKNOWN_PARAMETER,
+        CLIC_ERROR_BAD_SYNTAX,
+        CLIC_ERROR_MISSING_VALUE,
+        CLIC_ERROR_INVALID_VALUE,
+        CLIC_ERROR_OUT_OF_RANGE,
+        CLIC_ERROR_MISSING_ARGUMENT,
+        CLIC_ERROR_TOO_MANY_ARGUMENTS,
+        CLIC_ERROR_CONF_FILE,
+        CLIC_ERROR_OUT_OF_MEMORY,
+        CLIC_ERROR_BAD_QUOTING,
+        CLIC_ERROR_TOO_MANY_TOKENS,
+    } error;
+    int token;                  // argv index of the offending token, or -1
+    char *message;              // caller buffer, can be NULL
+    size_t message_size;
+};
+
+void clic_compile(struct clic_ctx *ctx);
+
+void clic_ctx_init(struct clic_ctx *ctx, const struct clic_schema *schema);
+char *clic_ctx_render_help(const struct clic_ctx *ctx, int subcommand_id,
+    size_t *length);
+char *clic_ctx_complete(const struct clic_ctx *ctx, int argc,
+    const char *argv[], size_t *length);
+void clic_ctx_use_help_cache(struct clic_ctx *ctx,
+    const struct clic_help_text *texts, size_t nb);
+void clic_ctx_set_results(struct clic_ctx *ctx, const void *prototype,
+    size_t size);
+void clic_ctx_allow_conf(struct clic_ctx *ctx);
+int clic_ctx_parse(const struct clic_ctx *ctx, int argc, const char *argv[],
+    int *subcommand_id);
+int clic_ctx_parse_into(const struct clic_ctx *ctx, void *results, int argc,
+    const char *argv[], int *subcommand_id);
+enum clic_state clic_ctx_try_parse(const struct clic_ctx *ctx, void *results,
+    int argc, const char *argv[], struct clic_status *status);
+enum clic_state clic_ctx_try_parse_line(const struct clic_ctx *ctx,
+    void *results, char *line, const char *argv[], int argv_size,
+    struct clic_status *status);
+long clic_ctx_validate_batch(const struct clic_ctx *ctx, const char *path,
+    char separator, FILE *report);
+void clic_ctx_free_results(const struct clic_ctx *ctx, void *results);
+void clic_ctx_free(struct clic_ctx *ctx);
+
 #endif // CLIC_H
 
 
 #ifdef CLIC_IMPL
 
 #include <ctype.h>
+#include <float.h>
+#include <limits.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// set when a CLIC_DUMP_* macro makes clic_parse print something and exit
+#if defined(CLIC_DUMP_SYNOPSIS) || defined(CLIC_DUMP_OPTIONS) || \
+    defined(CLIC_DUMP_HELP_C) || defined(CLIC_DUMP_BASH_COMPLETION) || \
+    defined(CLIC_DUMP_ZSH_COMPLETION) || defined(CLIC_DUMP_FISH_COMPLETION)
+#define CLIC_DUMPING
+#endif
+
+#ifndef CLIC_MMAP
+#if defined(__unix__) || defined(__APPLE__)
+#define CLIC_MMAP               1
+#else
+#define CLIC_MMAP               0
+#endif
+#endif
+#if CLIC_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef CLIC_ENVIRON
+#if defined(__unix__) || defined(__APPLE__)
+extern char **environ;
+#define CLIC_ENVIRON            environ
+#elif defined(_WIN32)
+#define CLIC_ENVIRON            _environ
+#else
+#define CLIC_ENVIRON            NULL
+#endif
+#endif
+
+#ifndef CLIC_BATCH_MAX_TOKENS
+#define CLIC_BATCH_MAX_TOKENS   1024
+#endif
+#ifndef CLIC_ENV_MAX_LISTS
+#define CLIC_ENV_MAX_LISTS      16
+#endif
+#ifndef CLIC_ARENA_BLOCK_SIZE
+#define CLIC_ARENA_BLOCK_SIZE   16384
+#endif
 #ifndef CLIC_PADDING_1
 #define CLIC_PADDING_1          2
 #endif
@@ -136,88 +622,267 @@ int clic_parse(int argc, const char *argv[], int *subcommand_id);
 #define CLIC_PADDING_4          4
 #endif
 
-struct clic_elem {
-    struct clic_elem *next;
+struct clic_arena_block {
+    struct clic_arena_block *next;
+    max_align_t data[];
 };
-struct clic_list {
-    struct clic_elem *start, *end;
+struct clic_buffer {
+    char *data;
+    size_t length, capacity;
+    int is_fallible;            // running out of memory sets has_failed,
+    int has_failed;             // rather than exiting
 };
-#define clic_list_for(list, p, tag) \
-    for (struct tag *(p) = (struct tag *) (list).start; (p); (p) = (p)->next)
-#define clic_list_safe_for(list, p, tag) \
-    for (struct tag *(p) = (struct tag *) (list).start, *next; (p) && \
-        (next = (p)->next, 1); (p) = next)
-
-struct clic_flag_name {
-    struct clic_flag_name *next;
-    char name[2];
+struct clic_decimal {
+    unsigned char digits[800];  // without leading or trailing zeros
+    int nb_digits, point;       // 0.digits * 10^point
+    int is_truncated;           // non-zero digits are missing after digits
 };
-struct clic_param_or_arg {
-    struct clic_param_or_arg *next;
-    const char *name, *description;
-    enum clic_type {
-        CLIC_FLAG,
-        CLIC_BOOL,
-        CLIC_INT,
-        CLIC_STRING,
-    } type;
-    int is_required;
-    union clic_type_specific_data {
-        struct {
-            int scalar_default_value, *scalar_variable, mask;
-        };
-        struct {
-            const char *string_default_value, **string_variable;
-            int restrict_to_declared_options;
-            struct clic_list string_options;
-        };
-    } data;
+struct clic_env_lists {
+    struct {
+        const struct clic_param_or_arg *param;
+        const char *variable;   // NAME=value, NAME being len characters long
+        size_t len;
+    } entries[CLIC_ENV_MAX_LISTS];
+    size_t count;
+    int is_truncated;           // some entries did not fit
 };
-struct clic_scope {
-    struct clic_scope *next;
-    int subcommand_id;
-    const char *name, *description;
-    struct clic_list params, args;
-    int accept_unnamed_arguments;
+struct clic_file {
+    char *data;
+    size_t size;
+    int is_mapped;              // else allocated
+};
+struct clic_kept_file {
+    struct clic_kept_file *next;
+    const void *results;        // whose strings point into file or copy
+    struct clic_file file;
+    char *copy;                 // of the last line, if it was not terminated
+};
+struct clic_kept_files {
+    _Atomic(struct clic_kept_file *) head;  // pushed by concurrent parses
+};
+struct clic_nearest {
+    uint64_t peq[UCHAR_MAX + 1];    // bit i set for the character of name at i
+    size_t len, distance;           // distance to beat
+    const char *name;               // nearest candidate so far, or NULL
 };
-struct clic_string_option {
-    struct clic_string_option *next;
-    const char *param_or_arg_name, *value;
+union clic_value {
+    int scalar;
+    const char *string;
+    long long_value;
+    int64_t int64_value;
+    uint64_t uint64_value;
+    size_t size_value;
+    struct {
+        union {
+            int *ints;
+            const char **strings;
+        };
+        size_t count;
+    } list;
+    double double_value;
 };
 
-static struct clic_elem *clic_add_list_elem(struct clic_list *list,
-    size_t size);
+static void clic_add_completions(struct clic_arena *arena,
+    const struct clic_schema *schema, const struct clic_scope *scope,
+    int allow_conf, struct clic_trie *trie);
 static void clic_add_param_or_arg(int subcommand_id, const char *name,
     const char *description, enum clic_type type, int is_required,
     union clic_type_specific_data data);
 static void clic_add_param_or_arg_string_option(int subcommand_id,
     int is_required, const char *param_or_arg_name, const char *value);
+static void clic_add_short_param(struct clic_arena *arena,
+    struct clic_scope *scope, size_t position);
+static void *clic_arena_alloc(struct clic_arena *arena, size_t size);
+static void clic_arena_free(struct clic_arena *arena);
+static void *clic_arena_grow(struct clic_arena *arena, void *array, size_t nb,
+    size_t size);
+static const struct clic_param_or_arg *clic_bind(const struct clic_ctx *ctx,
+    void *results, const struct clic_param_or_arg *param_or_arg,
+    struct clic_param_or_arg *bound);
+static void clic_bind_value(struct clic_param_or_arg *param_or_arg,
+    union clic_value *value);
+static int clic_bprintf(struct clic_buffer *buffer, const char *format, ...);
 static void clic_check_initialized_and_not_parsed(void);
 static void clic_check_name_correctness(const char *name);
 static struct clic_param_or_arg *clic_check_param_or_arg_declaration(
-    struct clic_list list, const char *param_or_arg_name,
-    int should_be_declared);
+    const struct clic_scope *scope, int is_required,
+    const char *param_or_arg_name, int should_be_declared);
+static void clic_check_scope(const struct clic_scope *scope);
 static struct clic_scope *clic_check_subcommmand_declaration(int subcommand_id,
     const char *subcommand_name, int should_be_declared);
+static void clic_compile_scope(struct clic_arena *arena,
+    struct clic_scope *scope);
+static void clic_decimal_shift(struct clic_decimal *d, int shift);
+static enum clic_state clic_error(struct clic_status *status,
+    enum clic_error_code code, int token, const char *format, ...);
+static int clic_expand_abbreviation(const struct clic_scope *scope,
+    const char *ns, const char *s, size_t len, const char **name,
+    size_t *word_len);
+static int clic_expand_param(const struct clic_scope *scope, const char *s,
+    const char **name, size_t *len, struct clic_status *status, int token);
+static int clic_expand_subcommand(const struct clic_schema *schema,
+    const char *s, const struct clic_scope **subcommand,
+    struct clic_status *status);
 static void clic_fail(const char *error_message, ...);
-static int clic_parse_param_or_arg(struct clic_param_or_arg param_or_arg,
-    const char *arg1, const char *arg2);
-static void clic_print_help(struct clic_scope scope);
-static void clic_print_help_param_or_arg(struct clic_param_or_arg param_or_arg);
-static void clic_print_options(void);
-static void clic_print_synopsis(void);
+static const struct clic_param_or_arg *clic_find_param_or_arg(
+    const struct clic_scope *scope, int is_required, const char *name,
+    size_t len);
+static const struct clic_param_or_arg *clic_find_env_param(
+    const struct clic_scope *scope, const char *name, size_t len);
+static const struct clic_scope *clic_find_scope(
+    const struct clic_schema *schema, int subcommand_id);
+static const struct clic_param_or_arg *clic_find_short_param(
+    const struct clic_scope *scope, unsigned char c);
+static const struct clic_scope *clic_find_subcommand(
+    const struct clic_schema *schema, const char *name, size_t len);
+static size_t clic_hash(const char *name, size_t len);
+static void clic_id_index_add(struct clic_arena *arena,
+    struct clic_id_index *index, int subcommand_id, size_t position);
+static const struct clic_id_index_slot *clic_id_index_find(
+    const struct clic_id_index *index, int subcommand_id);
+static void clic_index_add(struct clic_arena *arena, struct clic_index *index,
+    const char *name, size_t position);
+static void clic_index_env_names(struct clic_arena *arena,
+    struct clic_scope *scope);
+static const struct clic_index_slot *clic_index_find(
+    const struct clic_index *index, const char *name, size_t len);
+static void clic_keep_file(struct clic_kept_files *kept_files,
+    struct clic_kept_file *kept);
+static int clic_map_file(const char *path, struct clic_file *file,
+    struct clic_status *status, int token);
+static void clic_nearest_add(struct clic_nearest *nearest,
+    const char *candidate);
+static void clic_nearest_init(struct clic_nearest *nearest, const char *name,
+    size_t len);
+static int clic_parse_conf(const struct clic_ctx *ctx, void *results,
+    const struct clic_scope *scope, const char *path,
+    struct clic_status *status, int token);
+static int clic_parse_double(const struct clic_param_or_arg *param_or_arg,
+    const char *s, struct clic_status *status, int token);
+static int clic_parse_env(const struct clic_ctx *ctx, void *results,
+    const struct clic_scope *scope, struct clic_env_lists *lists,
+    struct clic_status *status);
+static int clic_parse_env_lists(const struct clic_ctx *ctx, void *results,
+    const struct clic_scope *scope, const struct clic_env_lists *lists,
+    struct clic_status *status);
+static int clic_parse_env_value(const struct clic_ctx *ctx, void *results,
+    const struct clic_param_or_arg *param, const char *variable, size_t len,
+    struct clic_status *status);
+static int clic_parse_integer(const struct clic_param_or_arg *param_or_arg,
+    const char *s, struct clic_status *status, int token);
+static int clic_parse_list_value(const struct clic_param_or_arg *param_or_arg,
+    const char *s, struct clic_status *status, int token);
+static int clic_parse_param_or_arg(const struct clic_param_or_arg *param_or_arg,
+    const char *arg1, const char *arg2, int *nb_processed_arguments,
+    struct clic_status *status, int token);
+static int clic_parse_short_params(const struct clic_ctx *ctx, void *results,
+    const struct clic_scope *scope, const char *argv[],
+    int *nb_processed_arguments, struct clic_status *status);
+static int clic_parse_value(const struct clic_param_or_arg *param_or_arg,
+    const char *s, struct clic_status *status, int token);
+static enum clic_state clic_prefix_error(struct clic_status *status,
+    const char *format, ...);
+#ifdef CLIC_DUMP_BASH_COMPLETION
+static void clic_print_bash_completion(const struct clic_ctx *ctx);
+#endif
+#ifndef CLIC_DUMPING
+static void clic_print_completions(const struct clic_ctx *ctx, int argc,
+    const char *argv[]);
+#endif
+#ifdef CLIC_DUMP_FISH_COMPLETION
+static void clic_print_fish_completion(const struct clic_ctx *ctx);
+#endif
+#ifndef CLIC_DUMPING
+static void clic_print_help(const struct clic_ctx *ctx,
+    const struct clic_scope *scope);
+#endif
+#ifdef CLIC_DUMP_HELP_C
+static void clic_print_help_c(const struct clic_ctx *ctx);
+#endif
+#ifdef CLIC_DUMP_OPTIONS
+static void clic_print_options(const struct clic_ctx *ctx);
+#endif
+#ifdef CLIC_DUMP_SYNOPSIS
+static void clic_print_synopsis(const struct clic_ctx *ctx);
+#endif
+#ifdef CLIC_DUMP_ZSH_COMPLETION
+static void clic_print_zsh_completion(const struct clic_ctx *ctx);
+#endif
+static int clic_read_double(const char *s, double *value);
+static void *clic_rebase(const struct clic_ctx *ctx, void *results,
+    const void *variable);
+static void clic_release_files(struct clic_kept_files *kept_files,
+    const void *results, int all);
+static void clic_reset_status(struct clic_status *status);
+static void clic_set_defaults(const struct clic_ctx *ctx, void *results,
+    const struct clic_scope *scope);
 static void clic_set_flag_or_bool(int *variable, int value, int mask);
+static void clic_set_integer(const struct clic_param_or_arg *param_or_arg,
+    int64_t signed_value, uint64_t unsigned_value);
+static int clic_split_line(char *line, const char *argv[], int argv_size,
+    int *argc, struct clic_status *status);
+static const char *clic_suggest_param(const struct clic_ctx *ctx,
+    const struct clic_scope *scope, const char *name, size_t len,
+    int negated);
+static const char *clic_suggest_subcommand(const struct clic_schema *schema,
+    const char *name);
+static size_t clic_trie_insert(struct clic_arena *arena,
+    struct clic_trie *trie, size_t node, const char *s, size_t len);
+static size_t clic_trie_walk(const struct clic_trie *trie, size_t node,
+    const char *s, size_t len);
+static void clic_trie_write(const struct clic_trie *trie, size_t node,
+    struct clic_buffer *path, struct clic_buffer *b);
+static const char *clic_type_name(enum clic_type type);
+static void clic_unmap_file(const struct clic_file *file);
+static void clic_write_abbreviations(const struct clic_scope *scope,
+    const char *ns, const char *s, size_t len, struct clic_buffer *b);
+static void clic_write_default_value(struct clic_buffer *b,
+    const struct clic_param_or_arg *param_or_arg);
+#if defined(CLIC_DUMP_BASH_COMPLETION) || defined(CLIC_DUMP_ZSH_COMPLETION) || \
+    defined(CLIC_DUMP_FISH_COMPLETION)
+static void clic_write_escaped(struct clic_buffer *b, const char *s,
+    const char *specials);
+#endif
+#ifdef CLIC_DUMP_FISH_COMPLETION
+static void clic_write_fish_options(struct clic_buffer *b,
+    const struct clic_param_or_arg *param_or_arg);
+#endif
+static void clic_write_help(const struct clic_ctx *ctx, struct clic_buffer *b,
+    const struct clic_scope *scope);
+static void clic_write_help_param_or_arg(struct clic_buffer *b,
+    const struct clic_param_or_arg *param_or_arg);
+#if defined(CLIC_DUMP_SYNOPSIS) || defined(CLIC_DUMP_OPTIONS)
+static void clic_write_roff(struct clic_buffer *b, const char *s, size_t len);
+#endif
+#ifdef CLIC_DUMP_OPTIONS
+static void clic_write_roff_param_or_arg(struct clic_buffer *b,
+    const struct clic_param_or_arg *param_or_arg);
+#endif
+#if defined(CLIC_DUMP_BASH_COMPLETION) || defined(CLIC_DUMP_ZSH_COMPLETION)
+static void clic_write_shell_function(struct clic_buffer *b,
+    const char *program_name);
+#endif
+#ifdef CLIC_DUMP_ZSH_COMPLETION
+static void clic_write_zsh_action(struct clic_buffer *b,
+    const struct clic_param_or_arg *param_or_arg);
+#endif
+#ifdef CLIC_DUMP_ZSH_COMPLETION
+static void clic_write_zsh_arguments(struct clic_buffer *b,
+    const struct clic_schema *schema, const struct clic_scope *scope,
+    int indent);
+#endif
 
 static struct {
     int is_init, is_parsed;
-    struct clic_list flag_names, subcommand_scopes;
-    struct clic_metadata {
-        const char *version, *license;
-        int require_subcommand;
-    } metadata;
-    struct clic_scope main_scope;
+    struct clic_schema declared;
+    struct clic_ctx ctx;
 } clic_globals;
 
+#ifdef CLIC_ARENA_SIZE
+static max_align_t clic_arena_buffer[(CLIC_ARENA_SIZE + sizeof(max_align_t) - 1)
+    / sizeof(max_align_t)];
+#endif
+
 void
 clic_init(const char *program, const char *version, const char *license,
     const char *description, int require_subcommand,
@@ -225,16 +890,48 @@ clic_init(const char *program, const char *version, const char *license,
 {
     clic_globals.is_init = 1;
     clic_globals.is_parsed = 0;
-    clic_globals.metadata = (struct clic_metadata) {
-        .version = version,
-        .license = license,
-        .require_subcommand = require_subcommand,
+    clic_globals.declared = (struct clic_schema) {
+        .metadata = {
+            .version = version,
+            .license = license,
+            .require_subcommand = require_subcommand,
+        },
+        .main_scope = {
+            .name = program,
+            .description = description,
+            .accept_unnamed_arguments = accept_unnamed_arguments,
+        },
     };
-    clic_globals.main_scope = (struct clic_scope) {
-        .name = program,
-        .description = description,
-        .accept_unnamed_arguments = accept_unnamed_arguments,
+    clic_globals.ctx = (struct clic_ctx) {
+        .schema = &clic_globals.declared,
+        .program_name = program,
+        .allow_conf = 1,
     };
+#ifdef CLIC_ARENA_SIZE
+    clic_globals.ctx.arena.cur = (char *) clic_arena_buffer;
+    clic_globals.ctx.arena.end = (char *) clic_arena_buffer +
+        sizeof(clic_arena_buffer);
+#endif
+}
+
+void
+clic_set_env_prefix(const char *prefix)
+{
+    clic_check_initialized_and_not_parsed();
+    if (clic_globals.ctx.schema != &clic_globals.declared) {
+        clic_fail("cannot declare on top of a static schema");
+    }
+    clic_globals.declared.metadata.env_prefix = prefix;
+}
+
+void
+clic_allow_abbreviations(void)
+{
+    clic_check_initialized_and_not_parsed();
+    if (clic_globals.ctx.schema != &clic_globals.declared) {
+        clic_fail("cannot declare on top of a static schema");
+    }
+    clic_globals.declared.metadata.allow_abbreviations = 1;
 }
 
 void
@@ -244,34 +941,37 @@ clic_add_subcommand(int subcommand_id, const char *name,
     clic_check_initialized_and_not_parsed();
     clic_check_name_correctness(name);
     clic_check_subcommmand_declaration(subcommand_id, name, 0);
-    struct clic_scope *subcommand_scope = (struct clic_scope *)
-        clic_add_list_elem(&clic_globals.subcommand_scopes,
-            sizeof(*subcommand_scope));
-    *subcommand_scope = (struct clic_scope) {
+    struct clic_schema *schema = &clic_globals.declared;
+    struct clic_scope *subcommands = clic_arena_grow(&clic_globals.ctx.arena,
+        (void *) schema->subcommands, schema->nb_subcommands,
+        sizeof(*subcommands));
+    subcommands[schema->nb_subcommands] = (struct clic_scope) {
         .subcommand_id = subcommand_id,
         .name = name,
         .description = description,
         .accept_unnamed_arguments = accept_unnamed_arguments,
     };
+    clic_index_add(&clic_globals.ctx.arena, &schema->subcommand_names, name,
+        schema->nb_subcommands);
+    clic_id_index_add(&clic_globals.ctx.arena, &schema->subcommand_ids,
+        subcommand_id, schema->nb_subcommands);
+    schema->subcommands = subcommands;
+    schema->nb_subcommands++;
 }
 
 void
 clic_add_param_flag(int subcommand_id, char name, const char *description,
     int *variable, int mask)
 {
-    struct clic_flag_name *flag_name = (struct clic_flag_name *)
-        clic_add_list_elem(&clic_globals.flag_names, sizeof(*flag_name));
-    flag_name->name[0] = name;
-    flag_name->name[1] = 0;
-    clic_add_param_or_arg(subcommand_id, flag_name->name, description,
+    char *flag_name = clic_arena_alloc(&clic_globals.ctx.arena, 2);
+    flag_name[0] = name;
+    flag_name[1] = 0;
+    clic_add_param_or_arg(subcommand_id, flag_name, description,
         CLIC_FLAG, 0, (union clic_type_specific_data) {
             .scalar_default_value = 0,
             .scalar_variable = variable,
             .mask = mask,
         });
-    if (variable) {
-        clic_set_flag_or_bool(variable, 0, mask);
-    }
 }
 
 void
@@ -284,9 +984,6 @@ clic_add_param_bool(int subcommand_id, const char *name,
             .scalar_variable = variable,
             .mask = mask,
         });
-    if (variable) {
-        clic_set_flag_or_bool(variable, default_value, mask);
-    }
 }
 
 void
@@ -298,9 +995,61 @@ clic_add_param_int(int subcommand_id, const char *name, const char *description,
             .scalar_default_value = default_value,
             .scalar_variable = variable,
         });
-    if (variable) {
-        *variable = default_value;
-    }
+}
+
+void
+clic_add_param_long(int subcommand_id, const char *name,
+    const char *description, long default_value, long *variable)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_LONG, 0,
+        (union clic_type_specific_data) {
+            .signed_default_value = default_value,
+            .integer_variable = variable,
+        });
+}
+
+void
+clic_add_param_int64(int subcommand_id, const char *name,
+    const char *description, int64_t default_value, int64_t *variable)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_INT64, 0,
+        (union clic_type_specific_data) {
+            .signed_default_value = default_value,
+            .integer_variable = variable,
+        });
+}
+
+void
+clic_add_param_uint64(int subcommand_id, const char *name,
+    const char *description, uint64_t default_value, uint64_t *variable)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_UINT64, 0,
+        (union clic_type_specific_data) {
+            .unsigned_default_value = default_value,
+            .integer_variable = variable,
+        });
+}
+
+void
+clic_add_param_size(int subcommand_id, const char *name,
+    const char *description, size_t default_value, size_t *variable)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_SIZE, 0,
+        (union clic_type_specific_data) {
+            .unsigned_default_value = default_value,
+            .integer_variable = variable,
+        });
+}
+
+void
+clic_add_param_double(int subcommand_id, const char *name,
+    const char *description, double default_value, double *variable)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_DOUBLE, 0,
+        (union clic_type_specific_data) {
+            .double_default_value = default_value,
+            .double_variable = variable,
+        });
 }
 
 void
@@ -314,9 +1063,28 @@ clic_add_param_string(int subcommand_id, const char *name,
             .string_variable = variable,
             .restrict_to_declared_options = restrict_to_declared_options,
         });
-    if (variable) {
-        *variable = default_value;
-    }
+}
+
+void
+clic_add_param_int_list(int subcommand_id, const char *name,
+    const char *description, int **variable, size_t *count)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_INT_LIST, 0,
+        (union clic_type_specific_data) {
+            .list_variable = variable,
+            .list_count = count,
+        });
+}
+
+void
+clic_add_param_string_list(int subcommand_id, const char *name,
+    const char *description, const char ***variable, size_t *count)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_STRING_LIST,
+        0, (union clic_type_specific_data) {
+            .list_variable = variable,
+            .list_count = count,
+        });
 }
 
 void
@@ -336,6 +1104,56 @@ clic_add_arg_int(int subcommand_id, const char *name, const char *description,
         });
 }
 
+void
+clic_add_arg_long(int subcommand_id, const char *name, const char *description,
+    long *variable)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_LONG, 1,
+        (union clic_type_specific_data) {
+            .integer_variable = variable,
+        });
+}
+
+void
+clic_add_arg_int64(int subcommand_id, const char *name,
+    const char *description, int64_t *variable)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_INT64, 1,
+        (union clic_type_specific_data) {
+            .integer_variable = variable,
+        });
+}
+
+void
+clic_add_arg_uint64(int subcommand_id, const char *name,
+    const char *description, uint64_t *variable)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_UINT64, 1,
+        (union clic_type_specific_data) {
+            .integer_variable = variable,
+        });
+}
+
+void
+clic_add_arg_size(int subcommand_id, const char *name, const char *description,
+    size_t *variable)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_SIZE, 1,
+        (union clic_type_specific_data) {
+            .integer_variable = variable,
+        });
+}
+
+void
+clic_add_arg_double(int subcommand_id, const char *name,
+    const char *description, double *variable)
+{
+    clic_add_param_or_arg(subcommand_id, name, description, CLIC_DOUBLE, 1,
+        (union clic_type_specific_data) {
+            .double_variable = variable,
+        });
+}
+
 void
 clic_add_arg_string(int subcommand_id, const char *name,
     const char *description, const char **variable,
@@ -355,510 +1173,3773 @@ clic_add_arg_string_option(int subcommand_id, const char *arg_name,
     clic_add_param_or_arg_string_option(subcommand_id, 1, arg_name, value);
 }
 
+void
+clic_init_static(const struct clic_schema *schema)
+{
+    // static tables have no room for the indexes and tries lookups go
+    // through, so they are compiled once here
+    clic_globals.is_init = 1;
+    clic_globals.is_parsed = 0;
+    clic_ctx_init(&clic_globals.ctx, schema);
+    clic_ctx_allow_conf(&clic_globals.ctx);
+}
+
+void
+clic_check_schema(const struct clic_schema *schema)
+{
+    // meant to be run once (e.g. in a test suite), so quadratic checks are fine
+    const struct clic_scope *subcommand;
+
+    clic_check_scope(&schema->main_scope);
+    for (size_t i = 0; i < schema->nb_subcommands; i++) {
+        subcommand = &schema->subcommands[i];
+        if (!subcommand->subcommand_id) {
+            clic_fail("0 is already implicitely used as the main scope identifier");
+        }
+        clic_check_name_correctness(subcommand->name);
+        for (size_t j = 0; j < i; j++) {
+            if (subcommand->subcommand_id ==
+                schema->subcommands[j].subcommand_id ||
+                !strcmp(subcommand->name, schema->subcommands[j].name)) {
+                clic_fail("subcommand identifier %d or name '%s' has already been declared",
+                    subcommand->subcommand_id, subcommand->name);
+            }
+        }
+        clic_check_scope(subcommand);
+    }
+}
+
+char *
+clic_render_help(int subcommand_id, size_t *length)
+{
+    clic_check_initialized_and_not_parsed();
+    return clic_ctx_render_help(&clic_globals.ctx, subcommand_id, length);
+}
+
+void
+clic_use_help_cache(const struct clic_help_text *texts, size_t nb)
+{
+    clic_check_initialized_and_not_parsed();
+    clic_ctx_use_help_cache(&clic_globals.ctx, texts, nb);
+}
+
 int
 clic_parse(int argc, const char *argv[], int *subcommand_id)
 {
-    int nb_processed_arguments = 0;
+    struct clic_schema *declared = &clic_globals.declared;
+    const struct clic_schema *schema;
+    struct clic_scope *scope;
+    int nb_processed_arguments;
 
     clic_check_initialized_and_not_parsed();
     clic_globals.is_init = 0;
     clic_globals.is_parsed = 1;
-    if (!clic_globals.main_scope.name) {
-        clic_globals.main_scope.name = argv[0];
+    for (size_t i = 0; clic_globals.ctx.schema == declared &&
+        i <= declared->nb_subcommands; i++) {
+        scope = i ? (struct clic_scope *) &declared->subcommands[i - 1] :
+            &declared->main_scope;
+        if (declared->metadata.env_prefix) {
+            clic_index_env_names(&clic_globals.ctx.arena, scope);
+        }
+        if (declared->metadata.allow_abbreviations) {
+            clic_add_completions(&clic_globals.ctx.arena, declared, scope,
+                clic_globals.ctx.allow_conf, &scope->completions);
+        }
     }
 
-#if defined(CLIC_DUMP_SYNOPSIS)
-    clic_print_synopsis();
-#elif defined(CLIC_DUMP_OPTIONS)
-    clic_print_options();
+    // unlike a context's parses, assign the default values of every scope
+    schema = clic_globals.ctx.schema;
+    for (size_t i = 0; i < schema->nb_subcommands; i++) {
+        clic_set_defaults(&clic_globals.ctx, NULL, &schema->subcommands[i]);
+    }
+    // conf files that variables point into are kept for the program lifetime
+    clic_globals.ctx.kept_files = NULL;
+    nb_processed_arguments = clic_ctx_parse(&clic_globals.ctx, argc, argv,
+        subcommand_id);
+
+    // cleanup
+    clic_ctx_free(&clic_globals.ctx);
+    clic_globals.declared = (struct clic_schema) {0};
+
+    return nb_processed_arguments;
+}
+
+void
+clic_compile(struct clic_ctx *ctx)
+{
+    // hand the declarations over to ctx, ending the global declaration
+    clic_check_initialized_and_not_parsed();
+    clic_ctx_init(ctx, clic_globals.ctx.schema);
+    ctx->program_name = clic_globals.ctx.program_name;
+    clic_ctx_use_help_cache(ctx, clic_globals.ctx.help_texts,
+        clic_globals.ctx.nb_help_texts);
+    clic_globals.is_init = 0;
+    clic_ctx_free(&clic_globals.ctx);
+    clic_globals.declared = (struct clic_schema) {0};
+}
+
+void
+clic_ctx_init(struct clic_ctx *ctx, const struct clic_schema *schema)
+{
+    // copy and index the scopes, so that ctx doesn't depend on the lifetime of
+    // the declarations and lookups don't fall back to linear scans
+    struct clic_schema *compiled;
+    struct clic_scope *subcommands;
+
+    *ctx = (struct clic_ctx) {
+        .program_name = schema->main_scope.name,
+    };
+    ctx->kept_files = clic_arena_alloc(&ctx->arena, sizeof(*ctx->kept_files));
+    atomic_init(&ctx->kept_files->head, NULL);
+    compiled = clic_arena_alloc(&ctx->arena, sizeof(*compiled));
+    subcommands = clic_arena_alloc(&ctx->arena,
+        schema->nb_subcommands * sizeof(*subcommands));
+    *compiled = (struct clic_schema) {
+        .metadata = schema->metadata,
+        .main_scope = schema->main_scope,
+        .subcommands = subcommands,
+        .nb_subcommands = schema->nb_subcommands,
+    };
+    clic_compile_scope(&ctx->arena, &compiled->main_scope);
+    if (schema->metadata.env_prefix) {
+        clic_index_env_names(&ctx->arena, &compiled->main_scope);
+    }
+    for (size_t i = 0; i < schema->nb_subcommands; i++) {
+        subcommands[i] = schema->subcommands[i];
+        clic_compile_scope(&ctx->arena, &subcommands[i]);
+        if (schema->metadata.env_prefix) {
+            clic_index_env_names(&ctx->arena, &subcommands[i]);
+        }
+        clic_add_completions(&ctx->arena, compiled, &subcommands[i],
+            ctx->allow_conf, &subcommands[i].completions);
+        clic_index_add(&ctx->arena, &compiled->subcommand_names,
+            subcommands[i].name, i);
+        clic_id_index_add(&ctx->arena, &compiled->subcommand_ids,
+            subcommands[i].subcommand_id, i);
+    }
+    clic_add_completions(&ctx->arena, compiled, &compiled->main_scope,
+        ctx->allow_conf, &compiled->main_scope.completions);
+    ctx->schema = compiled;
+}
+
+char *
+clic_ctx_render_help(const struct clic_ctx *ctx, int subcommand_id,
+    size_t *length)
+{
+    struct clic_buffer buffer = {0};
+
+    clic_write_help(ctx, &buffer, clic_find_scope(ctx->schema, subcommand_id));
+    if (length) {
+        *length = buffer.length;
+    }
+    return buffer.data;
+}
+
+char *
+clic_ctx_complete(const struct clic_ctx *ctx, int argc, const char *argv[],
+    size_t *length)
+{
+    // argv holds the words following the program name, the last one being
+    // completed
+    const struct clic_schema *schema = ctx->schema;
+    const struct clic_scope *scope = &schema->main_scope, *subcommand = NULL;
+    const struct clic_param_or_arg *param = NULL;
+    const char *word = argc > 0 ? argv[argc - 1] : "", *s, *name;
+    struct clic_buffer buffer = {0}, path = {0};
+    struct clic_arena arena = {0};
+    struct clic_status status = {0}; // of abbreviations, without message
+    struct clic_trie trie;
+    char position[32];
+    int i = 0, nb_args = 0, is_positional = 0, expects_value = 0;
+    size_t len;
+
+    // words are resolved like clic_ctx_try_parse does, abbreviations included
+    if (argc > 1 && !(subcommand = clic_find_subcommand(schema, argv[0],
+        strlen(argv[0]))) && schema->metadata.allow_abbreviations) {
+        clic_expand_subcommand(schema, argv[0], &subcommand, &status);
+    }
+    if (subcommand) {
+        scope = subcommand;
+        i = 1;
+    }
+    if (!(trie = scope->completions).nb_nodes) {
+        clic_add_completions(&arena, schema, scope, ctx->allow_conf, &trie);
+    }
+
+    // skip the words before the completed one, stopping on a parameter whose
+    // value is completed
+    for (; i < argc - 1; i++) {
+        s = argv[i];
+        expects_value = 0;
+        if (is_positional || s[0] != '-' || !s[1]) {
+            is_positional = 1;
+            nb_args++;
+        } else if (!strcmp(s, "--")) {
+            is_positional = 1;
+        } else if (s[1] == '-') {
+            name = s + 2;
+            len = strcspn(name, "=");
+            if (!(param = clic_find_param_or_arg(scope, 0, name, len)) &&
+                schema->metadata.allow_abbreviations &&
+                !clic_expand_param(scope, s, &name, &len, &status, i)) {
+                param = clic_find_param_or_arg(scope, 0, name, len);
+            }
+            expects_value = !strchr(s, '=') && (param ?
+                param->type != CLIC_FLAG && param->type != CLIC_BOOL :
+                ctx->allow_conf && len == 4 && !strncmp(name, "conf", 4));
+        } else {
+            for (size_t j = 1; s[j]; j++) {
+                if ((param = clic_find_short_param(scope, s[j])) &&
+                    param->type != CLIC_FLAG) {
+                    expects_value = !s[j + 1];
+                    break;
+                }
+            }
+        }
+        if (expects_value) {
+            // skip the value, unless it is the completed word
+            if (++i == argc - 1) {
+                break;
+            }
+            expects_value = 0;
+        }
+    }
+
+    // candidates, prefixed by the completed word
+    clic_bprintf(&buffer, "");
+    clic_bprintf(&path, "%s", word);
+    if (expects_value) {
+        if (param) {
+            clic_trie_write(&trie, clic_trie_walk(&trie,
+                clic_trie_walk(&trie, clic_trie_walk(&trie,
+                clic_trie_walk(&trie, 0, "=--", 3), param->name,
+                strlen(param->name)), "=", 1), word, strlen(word)), &path,
+                &buffer);
+        }
+    } else if (!is_positional && word[0] == '-') {
+        // values of restricted strings in --name=value
+        clic_trie_write(&trie, clic_trie_walk(&trie, clic_trie_walk(&trie, 0,
+            "=", strchr(word, '=') ? 1 : 0), word, strlen(word)), &path,
+            &buffer);
+    } else {
+        if (argc <= 1) {
+            clic_trie_write(&trie, clic_trie_walk(&trie,
+                clic_trie_walk(&trie, 0, " ", 1), word, strlen(word)), &path,
+                &buffer);
+        }
+        len = snprintf(position, sizeof(position), "=%d=", nb_args);
+        clic_trie_write(&trie, clic_trie_walk(&trie,
+            clic_trie_walk(&trie, 0, position, len), word, strlen(word)),
+            &path, &buffer);
+        if (!is_positional && !*word) {
+            // parameters can still be given
+            clic_bprintf(&path, "-");
+            clic_trie_write(&trie, clic_trie_walk(&trie, 0, "-", 1), &path,
+                &buffer);
+        }
+    }
+    free(path.data);
+    clic_arena_free(&arena);
+    if (length) {
+        *length = buffer.length;
+    }
+    return buffer.data;
+}
+
+void
+clic_ctx_use_help_cache(struct clic_ctx *ctx,
+    const struct clic_help_text *texts, size_t nb)
+{
+    ctx->help_texts = texts;
+    ctx->nb_help_texts = nb;
+}
+
+void
+clic_ctx_set_results(struct clic_ctx *ctx, const void *prototype, size_t size)
+{
+    ctx->results_prototype = prototype;
+    ctx->results_size = size;
+}
+
+void
+clic_ctx_allow_conf(struct clic_ctx *ctx)
+{
+    // --conf reads any file the command line names, so contexts parsing
+    // untrusted commands don't accept it unless asked to
+    const struct clic_schema *schema = ctx->schema;
+    struct clic_scope *scope;
+    size_t node;
+
+    ctx->allow_conf = 1;
+    for (size_t i = 0; i <= schema->nb_subcommands; i++) {
+        scope = (struct clic_scope *) (i ? &schema->subcommands[i - 1] :
+            &schema->main_scope);
+        if (scope->completions.nb_nodes &&
+            !clic_find_param_or_arg(scope, 0, "conf", 4)) {
+            node = clic_trie_insert(&ctx->arena, &scope->completions, 0,
+                "--conf", 6);
+            scope->completions.nodes[node].is_word = 1;
+            scope->completions.nodes[node].name = "conf";
+        }
+    }
+}
+
+int
+clic_ctx_parse(const struct clic_ctx *ctx, int argc, const char *argv[],
+    int *subcommand_id)
+{
+    return clic_ctx_parse_into(ctx, NULL, argc, argv, subcommand_id);
+}
+
+int
+clic_ctx_parse_into(const struct clic_ctx *ctx, void *results, int argc,
+    const char *argv[], int *subcommand_id)
+{
+    // ctx is not modified, so that it can be shared by concurrent parses
+    struct clic_ctx named_ctx;
+    char message[1024];
+    struct clic_status status = {
+        .message = message,
+        .message_size = sizeof(message),
+    };
+
+    if (!ctx->program_name) {
+        named_ctx = *ctx;
+        named_ctx.program_name = argv[0];
+        ctx = &named_ctx;
+    }
+
+#ifdef CLIC_DUMPING
+    // the dump printers exit before anything is parsed
+    (void) results;
+    (void) argc;
+    (void) subcommand_id;
+#endif
+#if defined(CLIC_DUMP_SYNOPSIS)
+    clic_print_synopsis(ctx);
+#elif defined(CLIC_DUMP_OPTIONS)
+    clic_print_options(ctx);
+#elif defined(CLIC_DUMP_HELP_C)
+    clic_print_help_c(ctx);
+#elif defined(CLIC_DUMP_BASH_COMPLETION)
+    clic_print_bash_completion(ctx);
+#elif defined(CLIC_DUMP_ZSH_COMPLETION)
+    clic_print_zsh_completion(ctx);
+#elif defined(CLIC_DUMP_FISH_COMPLETION)
+    clic_print_fish_completion(ctx);
 #else
+    if (argc > 1 && !strcmp(argv[1], "__complete") &&
+        !clic_find_subcommand(ctx->schema, argv[1], strlen(argv[1]))) {
+        clic_print_completions(ctx, argc - 2, argv + 2);
+    }
+    switch (clic_ctx_try_parse(ctx, results, argc, argv, &status)) {
+    case CLIC_PARSED:
+        break;
+    case CLIC_HELP:
+        clic_print_help(ctx, clic_find_scope(ctx->schema,
+            status.subcommand_id));
+        break;
+    case CLIC_VERSION:
+        printf("%s\n", ctx->schema->metadata.version);
+        exit(EXIT_SUCCESS);
+    case CLIC_ERROR:
+        clic_fail("%s", message);
+        break;
+    }
+    if (subcommand_id) {
+        *subcommand_id = status.subcommand_id;
+    }
+#endif // CLIC_DUMP_*
+
+    return status.nb_processed_arguments;
+}
+
+enum clic_state
+clic_ctx_try_parse(const struct clic_ctx *ctx, void *results, int argc,
+    const char *argv[], struct clic_status *status)
+{
+    const struct clic_schema *schema = ctx->schema;
     const char *s, *name;
-    int found;
-    struct clic_scope active_scope = clic_globals.main_scope;
+    const struct clic_param_or_arg *param, *arg;
+    struct clic_param_or_arg bound;
+    const struct clic_scope *scope = NULL, *active_scope = &schema->main_scope;
+    struct clic_env_lists env_lists = { .count = 0 };
+    int *nb_processed_arguments = &status->nb_processed_arguments, token;
+    int negated;
+    size_t len;
+
+    clic_reset_status(status);
+
+    // assign default values, only those of the invoked scopes being read
+    clic_set_defaults(ctx, results, &schema->main_scope);
 
     // detect subcommand
-    if (argc > 1) {
-        clic_list_for(clic_globals.subcommand_scopes, scope, clic_scope) {
-            if (strcmp(argv[1], scope->name))
+    if (argc > 1 && !(scope = clic_find_subcommand(schema, argv[1],
+        strlen(argv[1]))) && schema->metadata.allow_abbreviations &&
+        clic_expand_subcommand(schema, argv[1], &scope, status)) {
+        return CLIC_ERROR;
+    }
+    if (scope) {
+        active_scope = scope;
+        (*nb_processed_arguments)++;
+        clic_set_defaults(ctx, results, scope);
+    }
+    if (!active_scope->subcommand_id && schema->metadata.require_subcommand) {
+        if (argc > 1 && !strcmp(argv[1], "--help")) {
+            return status->state = CLIC_HELP;
+        }
+        if (argc > 1 && (name = clic_suggest_subcommand(schema, argv[1]))) {
+            return clic_error(status, CLIC_ERROR_SUBCOMMAND_NOT_FOUND, 1,
+                "subcommand not found, did you mean '%s'?", name);
+        }
+        return clic_error(status, CLIC_ERROR_SUBCOMMAND_NOT_FOUND,
+            argc > 1 ? 1 : -1, "subcommand not found");
+    }
+    status->subcommand_id = active_scope->subcommand_id;
+
+    // fall back on environment variables, overridden by the command line
+    if (schema->metadata.env_prefix && clic_parse_env(ctx, results,
+        active_scope, &env_lists, status)) {
+        return CLIC_ERROR;
+    }
+
+    // eat parameters
+    while ((s = argv[1 + *nb_processed_arguments])) {
+        if (!strcmp(s, "--")) {
+            (*nb_processed_arguments)++;
+            break;
+        }
+        if (s[0] == '-' && isalpha((unsigned char) s[1])) {
+            if (clic_parse_short_params(ctx, results, active_scope, argv,
+                nb_processed_arguments, status)) {
+                return CLIC_ERROR;
+            }
+            continue;
+        } else if ((negated = !strncmp(s, "--no-", 5))) {
+            name = s + 5;
+        } else if (!strncmp(s, "--", 2)) {
+            name = s + 2;
+        } else {
+            // not a parameter
+            break;
+        }
+        len = strcspn(name, "="); // --name=value
+        token = 1 + *nb_processed_arguments;
+        param = clic_find_param_or_arg(active_scope, 0, name, len);
+        if (!param && schema->metadata.allow_abbreviations) {
+            if (clic_expand_param(active_scope, s, &name, &len, status,
+                token)) {
+                return CLIC_ERROR;
+            }
+            param = clic_find_param_or_arg(active_scope, 0, name, len);
+        }
+        if (param) {
+            param = clic_bind(ctx, results, param, &bound);
+            if (clic_parse_param_or_arg(param, s, argv[token + 1],
+                nb_processed_arguments, status, token)) {
+                return CLIC_ERROR;
+            }
+        } else if (!negated && len == 4 && !strncmp(name, "conf", 4) &&
+            ctx->allow_conf) {
+            if ((s = strchr(s, '='))) {
+                s++;
+            } else if (!(s = argv[++token])) {
+                return clic_error(status, CLIC_ERROR_MISSING_VALUE, token - 1,
+                    "missing required value for parameter 'conf'");
+            }
+            if (clic_parse_conf(ctx, results, active_scope, s, status,
+                token)) {
+                return CLIC_ERROR;
+            }
+            *nb_processed_arguments = token;
+        } else if (!negated && !strchr(s, '=') && len == 4 &&
+            !strncmp(name, "help", 4)) {
+            return status->state = CLIC_HELP;
+        } else if (!negated && !strchr(s, '=') && len == 7 &&
+            !strncmp(name, "version", 7) && schema->metadata.version) {
+            return status->state = CLIC_VERSION;
+        } else {
+            name = s + (negated ? 5 : 2);
+            len = strcspn(name, "=");
+            if ((s = clic_suggest_param(ctx, active_scope, name, len,
+                negated))) {
+                return clic_error(status, CLIC_ERROR_UNKNOWN_PARAMETER, token,
+                    "unknown parameter '%.*s', did you mean '--%s%s'?",
+                    (int) len, name, negated ? "no-" : "", s);
+            }
+            return clic_error(status, CLIC_ERROR_UNKNOWN_PARAMETER, token,
+                "unknown parameter '%.*s'", (int) len, name);
+        }
+    }
+
+    // lists found in the environment, if the command line gave them none
+    if (schema->metadata.env_prefix && clic_parse_env_lists(ctx, results,
+        active_scope, &env_lists, status)) {
+        return CLIC_ERROR;
+    }
+
+    // eat named arguments
+    for (size_t i = 0; i < active_scope->nb_args; i++) {
+        arg = clic_bind(ctx, results, &active_scope->args[i], &bound);
+        if (!(s = argv[1 + *nb_processed_arguments])) {
+            return clic_error(status, CLIC_ERROR_MISSING_ARGUMENT, -1,
+                "missing required argument '%s'", arg->name);
+        }
+        if (clic_parse_param_or_arg(arg, s, NULL, nb_processed_arguments,
+            status, 1 + *nb_processed_arguments)) {
+            return CLIC_ERROR;
+        }
+    }
+
+    // check if there are unnamed arguments
+    if (!active_scope->accept_unnamed_arguments &&
+        1 + *nb_processed_arguments < argc) {
+        return clic_error(status, CLIC_ERROR_TOO_MANY_ARGUMENTS,
+            1 + *nb_processed_arguments, "too many arguments");
+    }
+
+    return CLIC_PARSED;
+}
+
+enum clic_state
+clic_ctx_try_parse_line(const struct clic_ctx *ctx, void *results, char *line,
+    const char *argv[], int argv_size, struct clic_status *status)
+{
+    // argv[0] is the program name, followed by the tokens of line
+    int argc;
+
+    clic_reset_status(status);
+    if (argv_size < 2) {
+        return clic_error(status, CLIC_ERROR_TOO_MANY_TOKENS, -1,
+            "argv is too small");
+    }
+    argv[0] = ctx->program_name ? ctx->program_name : "";
+    if (clic_split_line(line, argv + 1, argv_size - 1, &argc, status)) {
+        return CLIC_ERROR;
+    }
+    return clic_ctx_try_parse(ctx, results, 1 + argc, argv, status);
+}
+
+long
+clic_ctx_validate_batch(const struct clic_ctx *ctx, const char *path,
+    char separator, FILE *report)
+{
+    // records are parsed like lines given to clic_ctx_try_parse_line, skipping
+    // blank ones and comments, into scratch variables so that neither the
+    // declared variables nor the results prototype are modified
+    // returns the number of invalid records, or -1 if path cannot be read
+    const char *argv[CLIC_BATCH_MAX_TOKENS];
+    char message[1024], *end, *record, *next, *copy = NULL, *s;
+    size_t len, nb_records = 0, nb_values, k = 0;
+    struct clic_ctx scratch = *ctx;
+    struct clic_schema schema = *ctx->schema;
+    struct clic_scope *scope, *subcommands;
+    struct clic_param_or_arg *params;
+    union clic_value *values;
+    struct clic_file file;
+    struct clic_kept_files kept_files;
+    long nb_failures = 0;
+    struct clic_status status = {
+        .message = message,
+        .message_size = sizeof(message),
+    };
+
+    if (clic_map_file(path, &file, &status, -1)) {
+        if (report) fprintf(report, "%s\n", message);
+        return -1;
+    }
+
+    // the scratch schema shares everything but its parameters and arguments
+    // with ctx, indexes holding positions rather than pointers
+    nb_values = schema.main_scope.nb_params + schema.main_scope.nb_args;
+    for (size_t i = 0; i < schema.nb_subcommands; i++) {
+        nb_values += schema.subcommands[i].nb_params +
+            schema.subcommands[i].nb_args;
+    }
+    subcommands = malloc((schema.nb_subcommands + 1) * sizeof(*subcommands));
+    params = malloc((nb_values + 1) * sizeof(*params));
+    values = calloc(nb_values + 1, sizeof(*values));
+    if (!subcommands || !params || !values) {
+        if (report) fprintf(report, "out of memory\n");
+        free(subcommands);
+        free(params);
+        free(values);
+        clic_unmap_file(&file);
+        return -1;
+    }
+    for (size_t i = 0; i <= schema.nb_subcommands; i++) {
+        scope = i ? &subcommands[i - 1] : &schema.main_scope;
+        if (i) {
+            *scope = schema.subcommands[i - 1];
+        }
+        memcpy(params + k, scope->params,
+            scope->nb_params * sizeof(*params));
+        memcpy(params + k + scope->nb_params, scope->args,
+            scope->nb_args * sizeof(*params));
+        scope->params = params + k;
+        scope->args = params + k + scope->nb_params;
+        for (size_t j = 0; j < scope->nb_params + scope->nb_args; j++, k++) {
+            clic_bind_value(&params[k], &values[k]);
+        }
+    }
+    schema.subcommands = subcommands;
+    scratch.schema = &schema;
+    scratch.results_prototype = NULL;
+    scratch.results_size = 0;
+    atomic_init(&kept_files.head, NULL);
+    scratch.kept_files = &kept_files;
+
+    for (record = file.data, end = file.data + file.size; record < end;
+        record = next + 1) {
+        nb_records++;
+        if (!(next = memchr(record, separator, end - record))) {
+            // no room to terminate the last record, copy it
+            len = end - record;
+            if (!(copy = malloc(len + 1))) {
+                if (report) fprintf(report, "out of memory\n");
+                nb_failures = -1;
+                break;
+            }
+            memcpy(copy, record, len);
+            record = copy;
+            end = next = copy + len;
+        }
+        *next = '\0';
+        for (s = record; isspace((unsigned char) *s);) {
+            s++;
+        }
+        if (!*s || *s == '#') {
+            continue;
+        }
+        switch (clic_ctx_try_parse_line(&scratch, NULL, record, argv,
+            CLIC_COUNT(argv), &status)) {
+        case CLIC_PARSED:
+        case CLIC_HELP:
+        case CLIC_VERSION:
+            if (report) fprintf(report, "%zu: ok\n", nb_records);
+            break;
+        case CLIC_ERROR:
+            nb_failures++;
+            if (report) fprintf(report, "%zu: %s\n", nb_records, message);
+            break;
+        }
+
+        clic_ctx_free_results(&scratch, NULL);
+    }
+    free(copy);
+    free(subcommands);
+    free(params);
+    free(values);
+    clic_unmap_file(&file);
+    return nb_failures;
+}
+
+void
+clic_ctx_free_results(const struct clic_ctx *ctx, void *results)
+{
+    // frees the lists of results (or of the declared variables if it is NULL)
+    // for all scopes, leaving them empty, and the files their strings point
+    // into
+    const struct clic_schema *schema = ctx->schema;
+    const struct clic_scope *scope;
+    const struct clic_param_or_arg *param_or_arg;
+    struct clic_param_or_arg bound;
+
+    if (ctx->kept_files) {
+        clic_release_files(ctx->kept_files, results, 0);
+    }
+
+    for (size_t i = 0; i <= schema->nb_subcommands; i++) {
+        scope = i ? &schema->subcommands[i - 1] : &schema->main_scope;
+        for (size_t j = 0; j < scope->nb_params + scope->nb_args; j++) {
+            param_or_arg = clic_bind(ctx, results, j < scope->nb_params ?
+                &scope->params[j] : &scope->args[j - scope->nb_params],
+                &bound);
+            if ((param_or_arg->type != CLIC_INT_LIST &&
+                param_or_arg->type != CLIC_STRING_LIST) ||
+                !param_or_arg->data.list_variable ||
+                !param_or_arg->data.list_count) {
                 continue;
-            active_scope = *scope;
-            nb_processed_arguments++;
+            }
+            if (param_or_arg->type == CLIC_INT_LIST) {
+                free(*(int **) param_or_arg->data.list_variable);
+                *(int **) param_or_arg->data.list_variable = NULL;
+            } else {
+                free(*(const char ***) param_or_arg->data.list_variable);
+                *(const char ***) param_or_arg->data.list_variable = NULL;
+            }
+            *param_or_arg->data.list_count = 0;
+        }
+    }
+}
+
+void
+clic_ctx_free(struct clic_ctx *ctx)
+{
+    if (ctx->kept_files) {
+        clic_release_files(ctx->kept_files, NULL, 1);
+    }
+    clic_arena_free(&ctx->arena);
+    *ctx = (struct clic_ctx) {0};
+}
+
+static void
+clic_add_completions(struct clic_arena *arena,
+    const struct clic_schema *schema, const struct clic_scope *scope,
+    int allow_conf, struct clic_trie *trie)
+{
+    // parameters are stored as written, other words in namespaces: ' ' for
+    // subcommands, '=N=' for the values of the Nth argument and '=--name='
+    // for the values of a parameter
+    const struct clic_param_or_arg *param_or_arg;
+    const char *s;
+    char position[32];
+    size_t node, leaf, len;
+
+    *trie = (struct clic_trie) {0};
+    for (size_t i = 0; i < scope->nb_params + scope->nb_args; i++) {
+        param_or_arg = i < scope->nb_params ? &scope->params[i] :
+            &scope->args[i - scope->nb_params];
+        s = param_or_arg->name;
+        if (param_or_arg->is_required) {
+            len = snprintf(position, sizeof(position), "=%zu=",
+                i - scope->nb_params);
+            node = clic_trie_insert(arena, trie, 0, position, len);
+        } else {
+            if (param_or_arg->type == CLIC_BOOL) {
+                node = clic_trie_insert(arena, trie, 0, "--no-", 5);
+                node = clic_trie_insert(arena, trie, node, s, strlen(s));
+                trie->nodes[node].is_word = 1;
+                trie->nodes[node].name = s;
+            }
+            // one character names are given as -n, and also as --n unless
+            // they are flags
+            if (!s[1] && param_or_arg->type != CLIC_BOOL) {
+                node = clic_trie_insert(arena, trie, 0, "-", 1);
+                node = clic_trie_insert(arena, trie, node, s, 1);
+                trie->nodes[node].is_word = 1;
+                trie->nodes[node].name = s;
+            }
+            if (s[1] || param_or_arg->type != CLIC_FLAG) {
+                node = clic_trie_insert(arena, trie, 0, "--", 2);
+                node = clic_trie_insert(arena, trie, node, s, strlen(s));
+                trie->nodes[node].is_word = 1;
+                trie->nodes[node].name = s;
+            }
+            node = clic_trie_insert(arena, trie, 0, "=--", 3);
+            node = clic_trie_insert(arena, trie, node, s, strlen(s));
+            node = clic_trie_insert(arena, trie, node, "=", 1);
+        }
+        if (param_or_arg->type == CLIC_STRING &&
+            param_or_arg->data.restrict_to_declared_options) {
+            for (size_t j = 0; j < param_or_arg->data.nb_string_options; j++) {
+                s = param_or_arg->data.string_options[j];
+                leaf = clic_trie_insert(arena, trie, node, s, strlen(s));
+                trie->nodes[leaf].is_word = 1;
+                trie->nodes[leaf].name = s;
+            }
+        }
+    }
+    for (size_t i = 0; !scope->subcommand_id && i < schema->nb_subcommands;
+        i++) {
+        s = schema->subcommands[i].name;
+        node = clic_trie_insert(arena, trie, 0, " ", 1);
+        node = clic_trie_insert(arena, trie, node, s, strlen(s));
+        trie->nodes[node].is_word = 1;
+        trie->nodes[node].name = s;
+    }
+    if (allow_conf && !clic_find_param_or_arg(scope, 0, "conf", 4)) {
+        node = clic_trie_insert(arena, trie, 0, "--conf", 6);
+        trie->nodes[node].is_word = 1;
+        trie->nodes[node].name = "conf";
+    }
+    if (schema->metadata.version) {
+        node = clic_trie_insert(arena, trie, 0, "--version", 9);
+        trie->nodes[node].is_word = 1;
+        trie->nodes[node].name = "version";
+    }
+    node = clic_trie_insert(arena, trie, 0, "--help", 6);
+    trie->nodes[node].is_word = 1;
+    trie->nodes[node].name = "help";
+}
+
+static void
+clic_add_param_or_arg(int subcommand_id, const char *name,
+    const char *description, enum clic_type type, int is_required,
+    union clic_type_specific_data data)
+{
+    clic_check_initialized_and_not_parsed();
+    clic_check_name_correctness(name);
+    struct clic_scope *scope = clic_check_subcommmand_declaration(subcommand_id,
+        NULL, 1);
+    clic_check_param_or_arg_declaration(scope, is_required, name, 0);
+    const struct clic_param_or_arg **list = is_required ? &scope->args :
+        &scope->params;
+    size_t *nb = is_required ? &scope->nb_args : &scope->nb_params;
+    struct clic_param_or_arg *params_or_args = clic_arena_grow(
+        &clic_globals.ctx.arena, (void *) *list, *nb, sizeof(*params_or_args));
+    params_or_args[*nb] = (struct clic_param_or_arg) {
+        .name = name,
+        .description = description,
+        .type = type,
+        .is_required = is_required,
+        .data = data,
+    };
+    clic_index_add(&clic_globals.ctx.arena,
+        is_required ? &scope->args_index : &scope->params_index, name, *nb);
+    *list = params_or_args;
+    if (!is_required && !name[1]) {
+        clic_add_short_param(&clic_globals.ctx.arena, scope, *nb);
+    }
+    (*nb)++;
+}
+
+static void
+clic_add_param_or_arg_string_option(int subcommand_id, int is_required,
+    const char *param_or_arg_name, const char *value)
+{
+    clic_check_initialized_and_not_parsed();
+    clic_check_name_correctness(param_or_arg_name);
+    struct clic_scope *scope = clic_check_subcommmand_declaration(subcommand_id,
+        NULL, 1);
+    struct clic_param_or_arg *param_or_arg =
+        clic_check_param_or_arg_declaration(scope, is_required,
+            param_or_arg_name, 1);
+    if (param_or_arg->type != CLIC_STRING ||
+        !param_or_arg->data.restrict_to_declared_options) {
+        clic_fail("parameter or argument '%s' is not a restricted-input string, "
+            "cannot declare an option '%s' for it",
+            param_or_arg_name, value);
+    }
+    const char **string_options = clic_arena_grow(&clic_globals.ctx.arena,
+        (void *) param_or_arg->data.string_options,
+        param_or_arg->data.nb_string_options, sizeof(*string_options));
+    string_options[param_or_arg->data.nb_string_options++] = value;
+    param_or_arg->data.string_options = string_options;
+}
+
+static void
+clic_add_short_param(struct clic_arena *arena, struct clic_scope *scope,
+    size_t position)
+{
+    // the parameter at position has a single character name
+    if (!scope->short_params) {
+        scope->short_params = clic_arena_alloc(arena,
+            128 * sizeof(*scope->short_params));
+        memset(scope->short_params, 0, 128 * sizeof(*scope->short_params));
+    }
+    scope->short_params[(unsigned char) scope->params[position].name[0]] =
+        position + 1;
+}
+
+static void *
+clic_arena_alloc(struct clic_arena *arena, size_t size)
+{
+    // bump allocation, aligned for any type
+    struct clic_arena_block *block;
+    size_t block_size;
+    void *res;
+
+    size = (size + sizeof(max_align_t) - 1) / sizeof(max_align_t) *
+        sizeof(max_align_t);
+    if (!arena->cur || (size_t) (arena->end - arena->cur) < size) {
+        block_size = size > CLIC_ARENA_BLOCK_SIZE ? size :
+            CLIC_ARENA_BLOCK_SIZE;
+        if (!(block = malloc(sizeof(*block) + block_size))) {
+            clic_fail("out of memory");
+        }
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->cur = (char *) block->data;
+        arena->end = arena->cur + block_size;
+    }
+    res = arena->cur;
+    arena->cur += size;
+    return res;
+}
+
+static void
+clic_arena_free(struct clic_arena *arena)
+{
+    for (struct clic_arena_block *block = arena->blocks, *next; block;
+        block = next) {
+        next = block->next;
+        free(block);
+    }
+    *arena = (struct clic_arena) {0};
+}
+
+static void *
+clic_arena_grow(struct clic_arena *arena, void *array, size_t nb, size_t size)
+{
+    // arrays built by clic_add_* have room for the smallest power of two (at
+    // least 4) of elements greater than or equal to nb
+    // returns an array with room for nb + 1 elements
+    void *res;
+
+    if (nb && (nb < 4 || nb & (nb - 1))) {
+        return array;
+    }
+    res = clic_arena_alloc(arena, (nb ? 2 * nb : 4) * size);
+    if (nb) {
+        memcpy(res, array, nb * size);
+    }
+    return res;
+}
+
+static const struct clic_param_or_arg *
+clic_bind(const struct clic_ctx *ctx, void *results,
+    const struct clic_param_or_arg *param_or_arg,
+    struct clic_param_or_arg *bound)
+{
+    // returns param_or_arg, or a copy of it in bound whose variable has been
+    // moved from the results prototype to results
+    if (!results) {
+        return param_or_arg;
+    }
+    *bound = *param_or_arg;
+    switch (bound->type) {
+    case CLIC_FLAG:
+    case CLIC_BOOL:
+    case CLIC_INT:
+        bound->data.scalar_variable = clic_rebase(ctx, results,
+            bound->data.scalar_variable);
+        break;
+    case CLIC_STRING:
+        bound->data.string_variable = clic_rebase(ctx, results,
+            bound->data.string_variable);
+        break;
+    case CLIC_LONG:
+    case CLIC_INT64:
+    case CLIC_UINT64:
+    case CLIC_SIZE:
+        bound->data.integer_variable = clic_rebase(ctx, results,
+            bound->data.integer_variable);
+        break;
+    case CLIC_INT_LIST:
+    case CLIC_STRING_LIST:
+        bound->data.list_variable = clic_rebase(ctx, results,
+            bound->data.list_variable);
+        bound->data.list_count = clic_rebase(ctx, results,
+            bound->data.list_count);
+        break;
+    case CLIC_DOUBLE:
+        bound->data.double_variable = clic_rebase(ctx, results,
+            bound->data.double_variable);
+        break;
+    }
+    return bound;
+}
+
+static void
+clic_bind_value(struct clic_param_or_arg *param_or_arg,
+    union clic_value *value)
+{
+    // points the variable of param_or_arg to value, whatever its type
+    switch (param_or_arg->type) {
+    case CLIC_FLAG:
+    case CLIC_BOOL:
+    case CLIC_INT:
+        param_or_arg->data.scalar_variable = &value->scalar;
+        break;
+    case CLIC_STRING:
+        param_or_arg->data.string_variable = &value->string;
+        break;
+    case CLIC_LONG:
+        param_or_arg->data.integer_variable = &value->long_value;
+        break;
+    case CLIC_INT64:
+        param_or_arg->data.integer_variable = &value->int64_value;
+        break;
+    case CLIC_UINT64:
+        param_or_arg->data.integer_variable = &value->uint64_value;
+        break;
+    case CLIC_SIZE:
+        param_or_arg->data.integer_variable = &value->size_value;
+        break;
+    case CLIC_INT_LIST:
+        param_or_arg->data.list_variable = &value->list.ints;
+        param_or_arg->data.list_count = &value->list.count;
+        break;
+    case CLIC_STRING_LIST:
+        param_or_arg->data.list_variable = &value->list.strings;
+        param_or_arg->data.list_count = &value->list.count;
+        break;
+    case CLIC_DOUBLE:
+        param_or_arg->data.double_variable = &value->double_value;
+        break;
+    }
+}
+
+static int
+clic_bprintf(struct clic_buffer *buffer, const char *format, ...)
+{
+    // returns the number of characters appended
+    size_t capacity = buffer->capacity;
+    va_list ap;
+    char *data;
+    int nb;
+
+    if (buffer->has_failed) {
+        return 0;
+    }
+    va_start(ap, format);
+    nb = vsnprintf(buffer->data ? buffer->data + buffer->length : NULL,
+        buffer->capacity - buffer->length, format, ap);
+    va_end(ap);
+    if (buffer->length + nb >= buffer->capacity) {
+        do {
+            capacity = capacity ? 2 * capacity : 4096;
+        } while (buffer->length + nb >= capacity);
+        if (!(data = realloc(buffer->data, capacity))) {
+            if (!buffer->is_fallible) {
+                clic_fail("out of memory");
+            }
+            buffer->has_failed = 1;
+            return 0;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+        va_start(ap, format);
+        vsnprintf(buffer->data + buffer->length,
+            buffer->capacity - buffer->length, format, ap);
+        va_end(ap);
+    }
+    buffer->length += nb;
+    return nb;
+}
+
+static void
+clic_check_initialized_and_not_parsed(void)
+{
+    if (!clic_globals.is_init) {
+        clic_fail("clic has not been initialized");
+    } else if (clic_globals.is_parsed) {
+        clic_fail("clic has already parsed command line arguments");
+    }
+}
+
+static void
+clic_check_name_correctness(const char *name)
+{
+    if (!name || !isalpha(*name)) {
+        clic_fail("invalid name '%s'", name ? name : "NULL");
+    }
+    for (const char *c = name; *c; c++) {
+        if (!(isalpha(*c) || *c == '-' || *c == '_')) {
+            clic_fail("invalid name '%s'", name);
+        }
+    }
+}
+
+static struct clic_param_or_arg *
+clic_check_param_or_arg_declaration(const struct clic_scope *scope,
+    int is_required, const char *param_or_arg_name, int should_be_declared)
+{
+    // if should_be_declared, return pointer
+    // else, return NULL
+    const struct clic_param_or_arg *param_or_arg;
+
+    clic_check_name_correctness(param_or_arg_name);
+    if ((param_or_arg = clic_find_param_or_arg(scope, is_required,
+        param_or_arg_name, strlen(param_or_arg_name)))) {
+        if (!should_be_declared) {
+            clic_fail("parameter/argument '%s' has already been declared in this scope",
+                param_or_arg_name);
+        }
+        return (struct clic_param_or_arg *) param_or_arg;
+    }
+    if (should_be_declared) {
+        clic_fail("parameter/argument '%s' has not been declared in this scope",
+            param_or_arg_name);
+    }
+    return NULL;
+}
+
+static void
+clic_check_scope(const struct clic_scope *scope)
+{
+    const struct clic_param_or_arg *list, *param_or_arg;
+    size_t nb;
+
+    for (int is_required = 0; is_required <= 1; is_required++) {
+        list = is_required ? scope->args : scope->params;
+        nb = is_required ? scope->nb_args : scope->nb_params;
+        for (size_t i = 0; i < nb; i++) {
+            param_or_arg = &list[i];
+            clic_check_name_correctness(param_or_arg->name);
+            for (size_t j = 0; j < i; j++) {
+                if (!strcmp(param_or_arg->name, list[j].name)) {
+                    clic_fail("parameter/argument '%s' has already been declared in this scope",
+                        param_or_arg->name);
+                }
+            }
+            if (param_or_arg->is_required != is_required ||
+                (is_required && (param_or_arg->type == CLIC_FLAG ||
+                param_or_arg->type == CLIC_BOOL ||
+                param_or_arg->type == CLIC_INT_LIST ||
+                param_or_arg->type == CLIC_STRING_LIST)) ||
+                (param_or_arg->type == CLIC_FLAG && param_or_arg->name[1])) {
+                clic_fail("parameter/argument '%s' is malformed",
+                    param_or_arg->name);
+            }
+            if (param_or_arg->type == CLIC_STRING &&
+                param_or_arg->data.nb_string_options &&
+                !param_or_arg->data.restrict_to_declared_options) {
+                clic_fail("parameter or argument '%s' is not a restricted-input string, "
+                    "cannot declare an option '%s' for it",
+                    param_or_arg->name, param_or_arg->data.string_options[0]);
+            }
+        }
+    }
+}
+
+static struct clic_scope *
+clic_check_subcommmand_declaration(int subcommand_id,
+    const char *subcommand_name, int should_be_declared)
+{
+    // if should_be_declared, only subcommand_id is checked, return pointer
+    // else, return NULL
+    struct clic_schema *schema = &clic_globals.declared;
+    const struct clic_id_index_slot *slot;
+
+    if (clic_globals.ctx.schema != schema) {
+        clic_fail("cannot declare on top of a static schema");
+    }
+    if (subcommand_id) {
+        if (should_be_declared) {
+            if ((slot = clic_id_index_find(&schema->subcommand_ids,
+                subcommand_id))) {
+                return (struct clic_scope *)
+                    &schema->subcommands[slot->position];
+            }
+            clic_fail("subcommand identifier %d has not been declared",
+                subcommand_id);
+        } else {
+            clic_check_name_correctness(subcommand_name);
+            if (clic_id_index_find(&schema->subcommand_ids, subcommand_id) ||
+                clic_index_find(&schema->subcommand_names, subcommand_name,
+                strlen(subcommand_name))) {
+                clic_fail("subcommand identifier %d or name '%s' has already been declared",
+                    subcommand_id, subcommand_name);
+            }
+        }
+    } else {
+        if (should_be_declared) {
+            return &schema->main_scope;
+        } else {
+            clic_fail("0 is already implicitely used as the main scope identifier");
+        }
+    }
+    return NULL;
+}
+
+static void
+clic_compile_scope(struct clic_arena *arena, struct clic_scope *scope)
+{
+    // copy the parameters and arguments of scope in arena, and index them
+    struct clic_param_or_arg *list, *param_or_arg;
+    const char **string_options;
+    char *flag_name;
+
+    scope->short_params = NULL;
+    for (int is_required = 0; is_required <= 1; is_required++) {
+        const struct clic_param_or_arg **src = is_required ? &scope->args :
+            &scope->params;
+        size_t nb = is_required ? scope->nb_args : scope->nb_params;
+        struct clic_index *index = is_required ? &scope->args_index :
+            &scope->params_index;
+
+        list = clic_arena_alloc(arena, nb * sizeof(*list));
+        *index = (struct clic_index) {0};
+        for (size_t i = 0; i < nb; i++) {
+            param_or_arg = &list[i];
+            *param_or_arg = (*src)[i];
+            if (param_or_arg->type == CLIC_FLAG) {
+                flag_name = clic_arena_alloc(arena, 2);
+                flag_name[0] = param_or_arg->name[0];
+                flag_name[1] = 0;
+                param_or_arg->name = flag_name;
+            } else if (param_or_arg->type == CLIC_STRING &&
+                param_or_arg->data.restrict_to_declared_options) {
+                string_options = clic_arena_alloc(arena,
+                    param_or_arg->data.nb_string_options *
+                    sizeof(*string_options));
+                for (size_t j = 0; j < param_or_arg->data.nb_string_options;
+                    j++) {
+                    string_options[j] = param_or_arg->data.string_options[j];
+                }
+                param_or_arg->data.string_options = string_options;
+            }
+            clic_index_add(arena, index, param_or_arg->name, i);
+        }
+        *src = list;
+        for (size_t i = 0; !is_required && i < nb; i++) {
+            if (!list[i].name[1]) {
+                clic_add_short_param(arena, scope, i);
+            }
+        }
+    }
+}
+
+static void
+clic_decimal_shift(struct clic_decimal *d, int shift)
+{
+    // multiply d by 2^shift, by steps of at most 60 bits so that digits fit in
+    // 64 bits
+    unsigned char buffer[sizeof(d->digits) + 20];
+    int step, r, w, nb;
+    uint64_t n, mask;
+
+    for (; shift > 0; shift -= step) {
+        step = shift > 60 ? 60 : shift;
+        // right to left, new digits being prepended
+        n = 0;
+        w = sizeof(buffer);
+        for (r = d->nb_digits - 1; r >= 0; r--) {
+            n += (uint64_t) d->digits[r] << step;
+            buffer[--w] = n % 10;
+            n /= 10;
+        }
+        for (; n; n /= 10) {
+            buffer[--w] = n % 10;
+        }
+        nb = (int) sizeof(buffer) - w;
+        d->point += nb - d->nb_digits;
+        d->nb_digits = nb < (int) sizeof(d->digits) ? nb :
+            (int) sizeof(d->digits);
+        memcpy(d->digits, buffer + w, d->nb_digits);
+        for (r = w + d->nb_digits; r < (int) sizeof(buffer); r++) {
+            d->is_truncated |= buffer[r] != 0;
+        }
+        while (d->nb_digits && !d->digits[d->nb_digits - 1]) {
+            d->nb_digits--;
+        }
+    }
+    for (; shift < 0; shift += step) {
+        step = shift < -60 ? 60 : -shift;
+        mask = ((uint64_t) 1 << step) - 1;
+        // left to right, once enough digits are read to produce one
+        n = 0;
+        for (r = 0; !(n >> step); r++) {
+            if (r >= d->nb_digits) {
+                if (!n) {
+                    d->nb_digits = 0;
+                    return;
+                }
+                for (; !(n >> step); r++) {
+                    n *= 10;
+                }
+                break;
+            }
+            n = n * 10 + d->digits[r];
+        }
+        d->point -= r - 1;
+        for (w = 0; r < d->nb_digits; r++) {
+            d->digits[w++] = n >> step;
+            n = (n & mask) * 10 + d->digits[r];
+        }
+        for (; n; n = (n & mask) * 10) {
+            if (w < (int) sizeof(d->digits)) {
+                d->digits[w++] = n >> step;
+            } else {
+                d->is_truncated |= (n >> step) != 0;
+            }
+        }
+        d->nb_digits = w;
+        while (d->nb_digits && !d->digits[d->nb_digits - 1]) {
+            d->nb_digits--;
+        }
+    }
+}
+
+static enum clic_state
+clic_error(struct clic_status *status, enum clic_error_code code, int token,
+    const char *format, ...)
+{
+    // returns CLIC_ERROR, so that failing functions can return clic_error(...)
+    va_list ap;
+
+    status->state = CLIC_ERROR;
+    status->error = code;
+    status->token = token;
+    if (status->message && status->message_size) {
+        va_start(ap, format);
+        vsnprintf(status->message, status->message_size, format, ap);
+        va_end(ap);
+    }
+    return CLIC_ERROR;
+}
+
+static int
+clic_expand_abbreviation(const struct clic_scope *scope, const char *ns,
+    const char *s, size_t len, const char **name, size_t *word_len)
+{
+    // looks up the words of namespace ns (see clic_add_completions) starting
+    // with the len first characters of s in the trie of scope: returns 1 if
+    // there is only one, or if s is one of them, name and word_len being set
+    // to its stored name and to its length within ns, 0 if there are several
+    // and -1 if there is none
+    const struct clic_trie *trie = &scope->completions;
+    size_t node, next, depth = len;
+
+    node = clic_trie_walk(trie, clic_trie_walk(trie, 0, ns, strlen(ns)), s,
+        len);
+
+    // follow the only branch below node, if any
+    while (node != SIZE_MAX && !trie->nodes[node].is_word &&
+        (next = trie->nodes[node].child) && !trie->nodes[next].sibling) {
+        node = next;
+        depth++;
+    }
+    if (node == SIZE_MAX) {
+        return -1;
+    } else if (!trie->nodes[node].is_word ||
+        (depth != len && trie->nodes[node].child)) {
+        return 0;
+    }
+    *name = trie->nodes[node].name;
+    *word_len = depth;
+    return 1;
+}
+
+static int
+clic_expand_param(const struct clic_scope *scope, const char *s,
+    const char **name, size_t *len, struct clic_status *status, int token)
+{
+    // replaces name (of length len, within the long parameter s) by the name
+    // of the only parameter or built-in option it abbreviates, if any, and
+    // fails if it abbreviates several
+    struct clic_buffer words = { .is_fallible = 1 };
+    const char *word;
+    size_t offset = *name - s, word_len;
+    int ret = 0;
+
+    switch (*len ? clic_expand_abbreviation(scope, "", s, offset + *len,
+        &word, &word_len) : -1) {
+    case 0:
+        // only errors allocate, to list the candidates
+        clic_write_abbreviations(scope, "", s, offset + *len, &words);
+        ret = words.has_failed ? clic_error(status, CLIC_ERROR_OUT_OF_MEMORY,
+            token, "out of memory") : clic_error(status,
+            CLIC_ERROR_UNKNOWN_PARAMETER, token,
+            "ambiguous parameter '%.*s' (%s)", (int) *len, *name, words.data);
+        break;
+    case 1:
+        // --n can abbreviate --no-color, but not mean it
+        if (offset + strlen(word) == word_len) {
+            *name = word;
+            *len = strlen(word);
+        }
+    }
+    free(words.data);
+    return ret;
+}
+
+static int
+clic_expand_subcommand(const struct clic_schema *schema, const char *s,
+    const struct clic_scope **subcommand, struct clic_status *status)
+{
+    // sets subcommand to the only one whose name starts with s, if any, and
+    // fails if there are several while a subcommand is required
+    struct clic_buffer words = { .is_fallible = 1 };
+    const char *name;
+    size_t len;
+    int ret = 0;
+
+    switch (*s ? clic_expand_abbreviation(&schema->main_scope, " ", s,
+        strlen(s), &name, &len) : -1) {
+    case 0:
+        if (!schema->metadata.require_subcommand) {
+            break;
+        }
+        clic_write_abbreviations(&schema->main_scope, " ", s, strlen(s),
+            &words);
+        ret = words.has_failed ? clic_error(status, CLIC_ERROR_OUT_OF_MEMORY,
+            1, "out of memory") : clic_error(status,
+            CLIC_ERROR_SUBCOMMAND_NOT_FOUND, 1,
+            "ambiguous subcommand '%s' (%s)", s, words.data);
+        break;
+    case 1:
+        *subcommand = clic_find_subcommand(schema, name, len);
+    }
+    free(words.data);
+    return ret;
+}
+
+static void
+clic_fail(const char *error_message, ...)
+{
+    va_list ap;
+    fprintf(stderr, "clic: ");
+    va_start(ap, error_message);
+    vfprintf(stderr, error_message, ap);
+    va_end(ap);
+    fprintf(stderr, "\n");
+    exit(EXIT_FAILURE);
+}
+
+static const struct clic_param_or_arg *
+clic_find_param_or_arg(const struct clic_scope *scope, int is_required,
+    const char *name, size_t len)
+{
+    // name does not need to be null-terminated, scope has been indexed
+    const struct clic_param_or_arg *list = is_required ? scope->args :
+        scope->params;
+    const struct clic_index_slot *slot = clic_index_find(is_required ?
+        &scope->args_index : &scope->params_index, name, len);
+
+    return slot ? &list[slot->position] : NULL;
+}
+
+static const struct clic_param_or_arg *
+clic_find_env_param(const struct clic_scope *scope, const char *name,
+    size_t len)
+{
+    // same as clic_find_param_or_arg, name being an environment variable name
+    // without prefix
+    const struct clic_index_slot *slot = clic_index_find(&scope->env_index,
+        name, len);
+
+    return slot ? &scope->params[slot->position] : NULL;
+}
+
+static const struct clic_scope *
+clic_find_scope(const struct clic_schema *schema, int subcommand_id)
+{
+    const struct clic_id_index_slot *slot;
+
+    if (!subcommand_id) {
+        return &schema->main_scope;
+    } else if ((slot = clic_id_index_find(&schema->subcommand_ids,
+        subcommand_id))) {
+        return &schema->subcommands[slot->position];
+    }
+    clic_fail("subcommand identifier %d has not been declared", subcommand_id);
+    return NULL;
+}
+
+static const struct clic_param_or_arg *
+clic_find_short_param(const struct clic_scope *scope, unsigned char c)
+{
+    // short_params is only allocated for scopes with such parameters
+    if (c >= 128 || !scope->short_params || !scope->short_params[c]) {
+        return NULL;
+    }
+    return &scope->params[scope->short_params[c] - 1];
+}
+
+static const struct clic_scope *
+clic_find_subcommand(const struct clic_schema *schema, const char *name,
+    size_t len)
+{
+    // same as clic_find_param_or_arg, for subcommands
+    const struct clic_index_slot *slot = clic_index_find(
+        &schema->subcommand_names, name, len);
+
+    return slot ? &schema->subcommands[slot->position] : NULL;
+}
+
+static size_t
+clic_hash(const char *name, size_t len)
+{
+    // FNV-1a
+    size_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char) name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void
+clic_id_index_add(struct clic_arena *arena, struct clic_id_index *index,
+    int subcommand_id, size_t position)
+{
+    // same scheme as clic_index_add, keyed by subcommand identifier
+    struct clic_id_index old = *index;
+    size_t i;
+
+    if (4 * (index->count + 1) > 3 * index->capacity) {
+        index->capacity = old.capacity ? 2 * old.capacity : 8;
+        index->count = 0;
+        index->slots = clic_arena_alloc(arena,
+            index->capacity * sizeof(*index->slots));
+        memset(index->slots, 0, index->capacity * sizeof(*index->slots));
+        for (i = 0; i < old.capacity; i++) {
+            if (old.slots[i].subcommand_id) {
+                clic_id_index_add(arena, index,
+                    old.slots[i].subcommand_id, old.slots[i].position);
+            }
+        }
+    }
+    i = (unsigned) subcommand_id * 2654435761u & (index->capacity - 1);
+    while (index->slots[i].subcommand_id) {
+        i = (i + 1) & (index->capacity - 1);
+    }
+    index->slots[i] = (struct clic_id_index_slot) {
+        .subcommand_id = subcommand_id,
+        .position = position,
+    };
+    index->count++;
+}
+
+static const struct clic_id_index_slot *
+clic_id_index_find(const struct clic_id_index *index, int subcommand_id)
+{
+    size_t i;
+
+    if (!index->capacity) {
+        return NULL;
+    }
+    i = (unsigned) subcommand_id * 2654435761u & (index->capacity - 1);
+    for (; index->slots[i].subcommand_id;
+        i = (i + 1) & (index->capacity - 1)) {
+        if (index->slots[i].subcommand_id == subcommand_id) {
+            return &index->slots[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+clic_index_add(struct clic_arena *arena, struct clic_index *index,
+    const char *name, size_t position)
+{
+    // open addressing with linear probing, kept at most 3/4 full
+    struct clic_index old = *index;
+    size_t i;
+
+    if (4 * (index->count + 1) > 3 * index->capacity) {
+        index->capacity = old.capacity ? 2 * old.capacity : 8;
+        index->count = 0;
+        index->slots = clic_arena_alloc(arena,
+            index->capacity * sizeof(*index->slots));
+        memset(index->slots, 0, index->capacity * sizeof(*index->slots));
+        for (i = 0; i < old.capacity; i++) {
+            if (old.slots[i].name) {
+                clic_index_add(arena, index, old.slots[i].name,
+                    old.slots[i].position);
+            }
+        }
+    }
+    i = clic_hash(name, strlen(name)) & (index->capacity - 1);
+    while (index->slots[i].name) {
+        i = (i + 1) & (index->capacity - 1);
+    }
+    index->slots[i] = (struct clic_index_slot) {
+        .name = name,
+        .position = position,
+    };
+    index->count++;
+}
+
+static void
+clic_index_env_names(struct clic_arena *arena, struct clic_scope *scope)
+{
+    // parameters are named in the environment in uppercase, dashes being
+    // replaced by underscores, the first one taking a name shared by several
+    char *name;
+    size_t len;
+
+    scope->env_index = (struct clic_index) {0};
+    for (size_t i = 0; i < scope->nb_params; i++) {
+        len = strlen(scope->params[i].name);
+        name = clic_arena_alloc(arena, len + 1);
+        for (size_t j = 0; j <= len; j++) {
+            name[j] = scope->params[i].name[j] == '-' ? '_' :
+                toupper((unsigned char) scope->params[i].name[j]);
+        }
+        if (!clic_index_find(&scope->env_index, name, len)) {
+            clic_index_add(arena, &scope->env_index, name, i);
+        }
+    }
+}
+
+static const struct clic_index_slot *
+clic_index_find(const struct clic_index *index, const char *name, size_t len)
+{
+    // name does not need to be null-terminated
+    size_t i;
+
+    if (!index->capacity) {
+        return NULL;
+    }
+    i = clic_hash(name, len) & (index->capacity - 1);
+    for (; index->slots[i].name; i = (i + 1) & (index->capacity - 1)) {
+        if (!strncmp(index->slots[i].name, name, len) &&
+            !index->slots[i].name[len]) {
+            return &index->slots[i];
+        }
+    }
+    return NULL;
+}
+
+static void
+clic_keep_file(struct clic_kept_files *kept_files, struct clic_kept_file *kept)
+{
+    // lock-free push, so that parses sharing a context don't wait on each other
+    kept->next = atomic_load(&kept_files->head);
+    while (!atomic_compare_exchange_weak(&kept_files->head, &kept->next,
+        kept)) {
+    }
+}
+
+static int
+clic_map_file(const char *path, struct clic_file *file,
+    struct clic_status *status, int token)
+{
+    // gives a private, writable copy of the file contents, mapped when it is
+    // a regular file with a size, read otherwise (pipes, devices, /proc files)
+    size_t capacity = 0;
+    char *data;
+    long nb;
+#if CLIC_MMAP
+    struct stat st;
+    int fd;
+
+    *file = (struct clic_file) {0};
+    if ((fd = open(path, O_RDONLY)) < 0) {
+        return clic_error(status, CLIC_ERROR_CONF_FILE, token,
+            "cannot read file '%s'", path);
+    }
+    if (fstat(fd, &st)) {
+        close(fd);
+        return clic_error(status, CLIC_ERROR_CONF_FILE, token,
+            "cannot read file '%s'", path);
+    }
+    if (S_ISREG(st.st_mode) && st.st_size) {
+        file->size = st.st_size;
+        file->data = mmap(NULL, file->size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (file->data == MAP_FAILED) {
+            *file = (struct clic_file) {0};
+            return clic_error(status, CLIC_ERROR_CONF_FILE, token,
+                "cannot read file '%s'", path);
+        }
+        file->is_mapped = 1;
+        return 0;
+    }
+#else
+    FILE *stream;
+
+    *file = (struct clic_file) {0};
+    if (!(stream = fopen(path, "rb"))) {
+        return clic_error(status, CLIC_ERROR_CONF_FILE, token,
+            "cannot read file '%s'", path);
+    }
+#endif // CLIC_MMAP
+
+    do {
+        if (file->size == capacity) {
+            capacity = capacity ? 2 * capacity : 4096;
+            if (!(data = realloc(file->data, capacity))) {
+                nb = -2;
+                break;
+            }
+            file->data = data;
+        }
+#if CLIC_MMAP
+        nb = read(fd, file->data + file->size, capacity - file->size);
+#else
+        nb = fread(file->data + file->size, 1, capacity - file->size, stream);
+#endif // CLIC_MMAP
+        if (nb > 0) {
+            file->size += nb;
+        }
+    } while (nb > 0);
+#if CLIC_MMAP
+    close(fd);
+#else
+    if (!nb && ferror(stream)) {
+        nb = -1;
+    }
+    fclose(stream);
+#endif // CLIC_MMAP
+    if (nb == -2) {
+        free(file->data);
+        *file = (struct clic_file) {0};
+        return clic_error(status, CLIC_ERROR_OUT_OF_MEMORY, token,
+            "out of memory");
+    } else if (nb < 0) {
+        free(file->data);
+        *file = (struct clic_file) {0};
+        return clic_error(status, CLIC_ERROR_CONF_FILE, token,
+            "cannot read file '%s'", path);
+    }
+    return 0;
+}
+
+static void
+clic_nearest_add(struct clic_nearest *nearest, const char *candidate)
+{
+    // edit distance between name and candidate with the bit-parallel algorithm
+    // of Myers (as formulated by Hyyro), one step per character of candidate:
+    // the vertical and horizontal deltas of the distance matrix D are followed
+    // along the diagonal ending on D[len][n], which never decreases, giving up
+    // as soon as candidate cannot be nearer than the best one
+    uint64_t pv = ~(uint64_t) 0, mv = 0, eq, xv, xh, ph, mh;
+    size_t n = strlen(candidate), m = nearest->len, i;
+    size_t distance = n > m ? n - m : m - n;    // lower bound until row 0
+
+    if (distance >= nearest->distance) {
+        return;
+    }
+    for (size_t j = 0; j < n; j++) {
+        eq = nearest->peq[(unsigned char) candidate[j]];
+        xv = eq | mv;
+        xh = (((eq & pv) + pv) ^ pv) | eq;
+        ph = mv | ~(xh | pv);
+        mh = pv & xh;
+        if (j + m >= n) {
+            // from D[i][j] to D[i + 1][j + 1]
+            i = j + m - n;
+            distance += (pv >> i & 1) + (ph >> i & 1) - (mv >> i & 1) -
+                (mh >> i & 1);
+            if (distance >= nearest->distance) {
+                return;
+            }
+        }
+        ph = ph << 1 | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    nearest->distance = distance;
+    nearest->name = candidate;
+}
+
+static void
+clic_nearest_init(struct clic_nearest *nearest, const char *name, size_t len)
+{
+    // candidates must be at most a third of name (plus one) away from it,
+    // names longer than a machine word get no suggestion
+    *nearest = (struct clic_nearest) {
+        .len = len,
+        .distance = len && len <= 64 ? len / 3 + 2 : 0,
+    };
+    for (size_t i = 0; nearest->distance && i < len; i++) {
+        nearest->peq[(unsigned char) name[i]] |= (uint64_t) 1 << i;
+    }
+}
+
+static int
+clic_parse_conf(const struct clic_ctx *ctx, void *results,
+    const struct clic_scope *scope, const char *path,
+    struct clic_status *status, int token)
+{
+    // lines are either `name = value` or a lone `name` (or `no-name`) for flags
+    // and booleans, values being terminated in place rather than copied, so
+    // the file is only kept when strings point into it, tied to results when
+    // ctx can release it (see clic_ctx_free_results), forever otherwise
+    // errors give line numbers but never quote the file, which may not be
+    // readable by whoever gets the message
+    const struct clic_param_or_arg *param;
+    struct clic_param_or_arg bound;
+    struct clic_file file;
+    struct clic_kept_file *kept;
+    size_t line = 0, len;
+    char *end, *s, *eol, *name, *value, *copy = NULL;
+    int negated, is_kept = 0, ret = 0;
+
+    if (clic_map_file(path, &file, status, token)) {
+        return CLIC_ERROR;
+    }
+    for (s = file.data, end = file.data + file.size; !ret && s < end;
+        s = eol + 1) {
+        line++;
+        if (!(eol = memchr(s, '\n', end - s))) {
+            // no room to terminate the last line, copy it
+            len = end - s;
+            if (!(copy = malloc(len + 1))) {
+                ret = clic_error(status, CLIC_ERROR_OUT_OF_MEMORY, token,
+                    "out of memory");
+                break;
+            }
+            memcpy(copy, s, len);
+            copy[len] = '\0';
+            s = copy;
+            end = eol = copy + len;
+        }
+
+        // trim, skip blank lines and comments
+        while (s < eol && isspace((unsigned char) *s)) {
+            s++;
+        }
+        for (value = eol; value > s && isspace((unsigned char) value[-1]);) {
+            value--;
+        }
+        if (s == value || *s == '#') {
+            continue;
+        }
+        *value = '\0';
+
+        // split name and value
+        for (name = s; *s && *s != '=' && !isspace((unsigned char) *s);) {
+            s++;
+        }
+        len = s - name;
+        while (isspace((unsigned char) *s)) {
+            s++;
+        }
+        if (*s == '=') {
+            for (s++; isspace((unsigned char) *s);) {
+                s++;
+            }
+            value = s;
+        } else if (!*s) {
+            value = NULL;
+        } else {
+            ret = clic_error(status, CLIC_ERROR_BAD_SYNTAX, token,
+                "%s:%zu: expected '=' after the parameter name", path, line);
+            break;
+        }
+
+        // assign
+        negated = 0;
+        if (!(param = clic_find_param_or_arg(scope, 0, name, len)) &&
+            len > 3 && !strncmp(name, "no-", 3) &&
+            (param = clic_find_param_or_arg(scope, 0, name + 3, len - 3))) {
+            negated = 1;
+        }
+        if (!param || (negated && param->type != CLIC_BOOL)) {
+            ret = clic_error(status, CLIC_ERROR_UNKNOWN_PARAMETER, token,
+                "%s:%zu: unknown parameter", path, line);
+            break;
+        }
+        param = clic_bind(ctx, results, param, &bound);
+        if (param->type == CLIC_FLAG || param->type == CLIC_BOOL) {
+            if (value) {
+                ret = clic_error(status, CLIC_ERROR_BAD_SYNTAX, token,
+                    "%s:%zu: bad syntax to set %s '%s'", path, line,
+                    clic_type_name(param->type), param->name);
+            } else if (param->data.scalar_variable) {
+                clic_set_flag_or_bool(param->data.scalar_variable, !negated,
+                    param->data.mask);
+            }
+        } else if (!value) {
+            ret = clic_error(status, CLIC_ERROR_MISSING_VALUE, token,
+                "%s:%zu: missing required value for parameter '%s'", path,
+                line, param->name);
+        } else if (clic_parse_value(param, value, status, token)) {
+            ret = status->error == CLIC_ERROR_OUT_OF_MEMORY ? CLIC_ERROR :
+                clic_error(status, status->error, token,
+                "%s:%zu: invalid value for parameter '%s'", path, line,
+                param->name);
+        } else if (param->type == CLIC_STRING ||
+            param->type == CLIC_STRING_LIST) {
+            is_kept = 1;
+        }
+    }
+    if (!ret && is_kept && ctx->kept_files) {
+        // until clic_ctx_free_results
+        if ((kept = malloc(sizeof(*kept)))) {
+            *kept = (struct clic_kept_file) {
+                .results = results,
+                .file = file,
+                .copy = copy,
+            };
+            clic_keep_file(ctx->kept_files, kept);
+        } else {
+            ret = clic_error(status, CLIC_ERROR_OUT_OF_MEMORY, token,
+                "out of memory");
+        }
+    }
+    if (ret || !is_kept) {
+        free(copy);
+        clic_unmap_file(&file);
+    }
+    return ret;
+}
+
+static int
+clic_parse_double(const struct clic_param_or_arg *param_or_arg, const char *s,
+    struct clic_status *status, int token)
+{
+    double value;
+
+    switch (clic_read_double(s, &value)) {
+    case CLIC_ERROR_INVALID_VALUE:
+        return clic_error(status, CLIC_ERROR_INVALID_VALUE, token,
+            "expected a number (%s), got '%s'", param_or_arg->name, s);
+    case CLIC_ERROR_OUT_OF_RANGE:
+        return clic_error(status, CLIC_ERROR_OUT_OF_RANGE, token,
+            "'%s' is out of range for %s", s, param_or_arg->name);
+    }
+    if (param_or_arg->data.double_variable) {
+        *param_or_arg->data.double_variable = value;
+    }
+    return 0;
+}
+
+static int
+clic_parse_env(const struct clic_ctx *ctx, void *results,
+    const struct clic_scope *scope, struct clic_env_lists *lists,
+    struct clic_status *status)
+{
+    // single pass over the environment, variables with the prefix being
+    // looked up in the index of scope; lists are only recorded, to be set by
+    // clic_parse_env_lists once the command line is parsed
+    const char *prefix = ctx->schema->metadata.env_prefix, *name;
+    const struct clic_param_or_arg *param;
+    char **environment = CLIC_ENVIRON;
+    size_t prefix_len = strlen(prefix), len;
+
+    lists->count = 0;
+    lists->is_truncated = 0;
+    for (; environment && *environment; environment++) {
+        if (strncmp(*environment, prefix, prefix_len)) {
+            continue;
+        }
+        name = *environment + prefix_len;
+        len = strcspn(name, "=");
+        if (!name[len] || !(param = clic_find_env_param(scope, name, len))) {
+            continue;
+        }
+        if (param->type != CLIC_INT_LIST && param->type != CLIC_STRING_LIST) {
+            if (clic_parse_env_value(ctx, results, param, *environment,
+                prefix_len + len, status)) {
+                return 1;
+            }
+        } else if (lists->count < CLIC_ENV_MAX_LISTS) {
+            lists->entries[lists->count].param = param;
+            lists->entries[lists->count].variable = *environment;
+            lists->entries[lists->count++].len = prefix_len + len;
+        } else {
+            lists->is_truncated = 1;
+        }
+    }
+    return 0;
+}
+
+static int
+clic_parse_env_lists(const struct clic_ctx *ctx, void *results,
+    const struct clic_scope *scope, const struct clic_env_lists *lists,
+    struct clic_status *status)
+{
+    // lists would gather values from both, so they only fall back on
+    // environment variables when the command line gave them none
+    const char *prefix = ctx->schema->metadata.env_prefix, *name;
+    const struct clic_param_or_arg *param, *list;
+    struct clic_param_or_arg bound;
+    char **environment = CLIC_ENVIRON;
+    size_t prefix_len = strlen(prefix), len;
+
+    for (size_t i = 0; i < lists->count && !lists->is_truncated; i++) {
+        list = clic_bind(ctx, results, lists->entries[i].param, &bound);
+        if (list->data.list_count && *list->data.list_count) {
+            continue;
+        }
+        if (clic_parse_env_value(ctx, results, lists->entries[i].param,
+            lists->entries[i].variable, lists->entries[i].len, status)) {
+            return 1;
+        }
+    }
+
+    // more lists than recorded, scan the environment again for them
+    for (; lists->is_truncated && environment && *environment;
+        environment++) {
+        if (strncmp(*environment, prefix, prefix_len)) {
+            continue;
+        }
+        name = *environment + prefix_len;
+        len = strcspn(name, "=");
+        if (!name[len] || !(param = clic_find_env_param(scope, name, len)) ||
+            (param->type != CLIC_INT_LIST &&
+            param->type != CLIC_STRING_LIST)) {
+            continue;
+        }
+        list = clic_bind(ctx, results, param, &bound);
+        if (list->data.list_count && *list->data.list_count) {
+            continue;
+        }
+        if (clic_parse_env_value(ctx, results, param, *environment,
+            prefix_len + len, status)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int
+clic_parse_env_value(const struct clic_ctx *ctx, void *results,
+    const struct clic_param_or_arg *param, const char *variable, size_t len,
+    struct clic_status *status)
+{
+    // variable is NAME=value, NAME being len characters long
+    static const char *const values[] = {
+        "0", "false", "no", "off", "1", "true", "yes", "on",
+    };
+    const char *value = variable + len + 1;
+    struct clic_param_or_arg bound;
+    size_t i;
+
+    param = clic_bind(ctx, results, param, &bound);
+    if (param->type != CLIC_FLAG && param->type != CLIC_BOOL) {
+        if (clic_parse_value(param, value, status, -1)) {
+            return clic_prefix_error(status, "%.*s: ", (int) len, variable);
+        }
+        return 0;
+    }
+    for (i = 0; i < CLIC_COUNT(values); i++) {
+        if (!strcmp(value, values[i]))
+            break;
+    }
+    if (i == CLIC_COUNT(values)) {
+        return clic_error(status, CLIC_ERROR_INVALID_VALUE, -1,
+            "%.*s: expected a boolean (%s), got '%s'", (int) len, variable,
+            param->name, value);
+    }
+    if (param->data.scalar_variable) {
+        clic_set_flag_or_bool(param->data.scalar_variable,
+            i >= CLIC_COUNT(values) / 2, param->data.mask);
+    }
+    return 0;
+}
+
+static int
+clic_parse_integer(const struct clic_param_or_arg *param_or_arg, const char *s,
+    struct clic_status *status, int token)
+{
+    // single pass over s, checking syntax and range
+    enum clic_type type = param_or_arg->type;
+    int is_signed = type == CLIC_INT || type == CLIC_LONG || type == CLIC_INT64;
+    int is_negative = 0, shift = 0;
+    uint64_t limit, value = 0, base = 10, digit;
+    const char *c = s, *digits;
+
+    limit = type == CLIC_INT ? INT_MAX :
+        type == CLIC_LONG ? LONG_MAX :
+        type == CLIC_INT64 ? INT64_MAX :
+        type == CLIC_SIZE ? SIZE_MAX :
+        UINT64_MAX;
+    if (*c == '+' || (*c == '-' && is_signed)) {
+        is_negative = *c++ == '-';
+    }
+    if (is_negative) {
+        limit++; // two's complement, |min| = max + 1
+    }
+    if (c[0] == '0' && (c[1] == 'x' || c[1] == 'X') &&
+        isxdigit((unsigned char) c[2])) {
+        base = 16;
+        c += 2;
+    }
+    for (digits = c; ; c++) {
+        if (*c >= '0' && *c <= '9') {
+            digit = *c - '0';
+        } else if (base == 16 && isxdigit((unsigned char) *c)) {
+            digit = tolower(*c) - 'a' + 10;
+        } else {
+            break;
+        }
+        if (value > (limit - digit) / base) {
+            return clic_error(status, CLIC_ERROR_OUT_OF_RANGE, token,
+                "'%s' is out of range for %s", s, param_or_arg->name);
+        }
+        value = value * base + digit;
+    }
+    if (c == digits) {
+        return clic_error(status, CLIC_ERROR_INVALID_VALUE, token,
+            "expected an integer (%s), got '%s'", param_or_arg->name, s);
+    }
+    switch (*c) {
+    case 'k': case 'K': shift = 10; c++; break;
+    case 'M': shift = 20; c++; break;
+    case 'G': shift = 30; c++; break;
+    case 'T': shift = 40; c++; break;
+    }
+    if (*c) {
+        return clic_error(status, CLIC_ERROR_INVALID_VALUE, token,
+            "expected an integer (%s), got '%s'", param_or_arg->name, s);
+    }
+    if (value > limit >> shift) {
+        return clic_error(status, CLIC_ERROR_OUT_OF_RANGE, token,
+            "'%s' is out of range for %s", s, param_or_arg->name);
+    }
+    value <<= shift;
+    clic_set_integer(param_or_arg, is_negative && value ?
+        -(int64_t) (value - 1) - 1 : (int64_t) value, value);
+    return 0;
+}
+
+static int
+clic_parse_list_value(const struct clic_param_or_arg *param_or_arg,
+    const char *s, struct clic_status *status, int token)
+{
+    // append s to the list, which has room for the smallest power of two (at
+    // least 4) of elements greater than or equal to its count, like arrays
+    // built by clic_add_*
+    // values also come from --conf files and the environment, which a
+    // counting pass over argv can't see, so lists grow instead: n values cost
+    // 1 + log2(n / 4) allocations, a single one up to 4 values
+    struct clic_param_or_arg element = *param_or_arg;
+    int is_int = param_or_arg->type == CLIC_INT_LIST;
+    size_t *count = param_or_arg->data.list_count;
+    int **ints = param_or_arg->data.list_variable;
+    const char ***strings = param_or_arg->data.list_variable;
+    void *res;
+
+    element.type = is_int ? CLIC_INT : CLIC_STRING;
+    element.data = (union clic_type_specific_data) {0};
+    if (!param_or_arg->data.list_variable || !count) {
+        return clic_parse_value(&element, s, status, token);
+    }
+    if (!*count || (*count >= 4 && !(*count & (*count - 1)))) {
+        res = realloc(is_int ? (void *) *ints : (void *) *strings,
+            (*count ? 2 * *count : 4) *
+            (is_int ? sizeof(**ints) : sizeof(**strings)));
+        if (!res) {
+            return clic_error(status, CLIC_ERROR_OUT_OF_MEMORY, token,
+                "out of memory");
+        }
+        if (is_int) {
+            *ints = res;
+        } else {
+            *strings = res;
+        }
+    }
+    if (is_int) {
+        element.data.scalar_variable = &(*ints)[*count];
+    } else {
+        element.data.string_variable = &(*strings)[*count];
+    }
+    if (clic_parse_value(&element, s, status, token)) {
+        return CLIC_ERROR;
+    }
+    (*count)++;
+    return 0;
+}
+
+static int
+clic_parse_param_or_arg(const struct clic_param_or_arg *param_or_arg,
+    const char *arg1, const char *arg2, int *nb_processed_arguments,
+    struct clic_status *status, int token)
+{
+    // arg1 and arg2 are command line arguments, token being the index of arg1
+    // adds the number of them used to parse param_or_arg to
+    // nb_processed_arguments
+    // check type correctness, value correctness, store in variable
+
+    const char *s = param_or_arg->is_required ? arg1 : arg2;
+    const char *attached = param_or_arg->is_required ? NULL :
+        strchr(arg1, '='); // --name=value
+
+    switch (param_or_arg->type) {
+    case CLIC_FLAG:
+        if (arg1[1] == '-') {
+            return clic_error(status, CLIC_ERROR_BAD_SYNTAX, token,
+                "bad syntax to set flag '%s'", param_or_arg->name);
+        }
+        if (param_or_arg->data.scalar_variable) {
+            clic_set_flag_or_bool(param_or_arg->data.scalar_variable, 1,
+                param_or_arg->data.mask);
+        }
+        *nb_processed_arguments += 1;
+        return 0;
+    case CLIC_BOOL:
+        if (strncmp(arg1, "--", 2) || attached) {
+            return clic_error(status, CLIC_ERROR_BAD_SYNTAX, token,
+                "bad syntax to set bool '%s'", param_or_arg->name);
+        }
+        if (param_or_arg->data.scalar_variable) {
+            clic_set_flag_or_bool(param_or_arg->data.scalar_variable,
+                strncmp(arg1, "--no-", 5) != 0, param_or_arg->data.mask);
+        }
+        *nb_processed_arguments += 1;
+        return 0;
+    case CLIC_INT:
+    case CLIC_STRING:
+    case CLIC_LONG:
+    case CLIC_INT64:
+    case CLIC_UINT64:
+    case CLIC_SIZE:
+    case CLIC_INT_LIST:
+    case CLIC_STRING_LIST:
+    case CLIC_DOUBLE:
+        if (!param_or_arg->is_required && !arg2 && !attached) {
+            return clic_error(status, CLIC_ERROR_MISSING_VALUE, token,
+                "missing required value for parameter '%s'",
+                param_or_arg->name);
+        } else if (!param_or_arg->is_required && (strncmp(arg1, "--", 2) ||
+            !strncmp(arg1, "--no-", 5))) {
+            return clic_error(status, CLIC_ERROR_BAD_SYNTAX, token,
+                "bad syntax to set %s '%s'",
+                clic_type_name(param_or_arg->type), param_or_arg->name);
+        } else if (attached) {
+            s = attached + 1;
+        }
+        if (clic_parse_value(param_or_arg, s, status,
+            param_or_arg->is_required || attached ? token : token + 1)) {
+            return CLIC_ERROR;
+        }
+        *nb_processed_arguments += param_or_arg->is_required || attached ?
+            1 : 2;
+        return 0;
+    }
+    return 0;
+}
+
+static int
+clic_parse_short_params(const struct clic_ctx *ctx, void *results,
+    const struct clic_scope *scope, const char *argv[],
+    int *nb_processed_arguments, struct clic_status *status)
+{
+    // -abc sets flags a, b and c, the value of a parameter being either the
+    // rest of the token (-j8) or the next command line argument (-j 8)
+    int token = 1 + *nb_processed_arguments;
+    const char *s = argv[token], *value;
+    const struct clic_param_or_arg *param;
+    struct clic_param_or_arg bound;
+
+    for (size_t i = 1; s[i]; i++) {
+        if (!(param = clic_find_short_param(scope, s[i]))) {
+            return clic_error(status, CLIC_ERROR_UNKNOWN_PARAMETER, token,
+                "unknown parameter '%c'", s[i]);
+        }
+        param = clic_bind(ctx, results, param, &bound);
+        switch (param->type) {
+        case CLIC_FLAG:
+            if (param->data.scalar_variable) {
+                clic_set_flag_or_bool(param->data.scalar_variable, 1,
+                    param->data.mask);
+            }
+            break;
+        case CLIC_BOOL:
+            return clic_error(status, CLIC_ERROR_BAD_SYNTAX, token,
+                "bad syntax to set bool '%s'", param->name);
+        default:
+            if (s[i + 1]) {
+                value = s + i + 1;
+            } else if (!(value = argv[++token])) {
+                return clic_error(status, CLIC_ERROR_MISSING_VALUE, token - 1,
+                    "missing required value for parameter '%s'",
+                    param->name);
+            }
+            if (clic_parse_value(param, value, status, token)) {
+                return CLIC_ERROR;
+            }
+            *nb_processed_arguments = token;
+            return 0;
+        }
+    }
+    *nb_processed_arguments = token;
+    return 0;
+}
+
+static int
+clic_parse_value(const struct clic_param_or_arg *param_or_arg, const char *s,
+    struct clic_status *status, int token)
+{
+    // check value correctness, store in variable
+    size_t i;
+
+    if (param_or_arg->type == CLIC_INT_LIST ||
+        param_or_arg->type == CLIC_STRING_LIST) {
+        return clic_parse_list_value(param_or_arg, s, status, token);
+    }
+    if (param_or_arg->type == CLIC_DOUBLE) {
+        return clic_parse_double(param_or_arg, s, status, token);
+    }
+    if (param_or_arg->type != CLIC_STRING) {
+        return clic_parse_integer(param_or_arg, s, status, token);
+    }
+    if (param_or_arg->data.restrict_to_declared_options) {
+        for (i = 0; i < param_or_arg->data.nb_string_options; i++) {
+            if (!strcmp(s, param_or_arg->data.string_options[i]))
+                break;
+        }
+        if (i == param_or_arg->data.nb_string_options) {
+            return clic_error(status, CLIC_ERROR_INVALID_VALUE, token,
+                "'%s' is not an acceptable value for %s", s,
+                param_or_arg->name);
+        }
+    }
+    if (param_or_arg->data.string_variable) {
+        *param_or_arg->data.string_variable = s;
+    }
+    return 0;
+}
+
+static enum clic_state
+clic_prefix_error(struct clic_status *status, const char *format, ...)
+{
+    // inserts the formatted text at the beginning of the message of the error
+    // already in status, truncating its end if needed
+    // returns CLIC_ERROR
+    char *message = status->message, c;
+    size_t n, len, size = status->message_size;
+    va_list ap;
+    int ret;
+
+    va_start(ap, format);
+    ret = vsnprintf(NULL, 0, format, ap);
+    va_end(ap);
+    if (!message || !size || ret < 0) {
+        return CLIC_ERROR;
+    }
+    n = (size_t) ret < size - 1 ? (size_t) ret : size - 1;
+    len = strlen(message);
+    len = len < size - 1 - n ? len : size - 1 - n;
+    memmove(message + n, message, len);
+    message[n + len] = '\0';
+    c = message[n];
+    va_start(ap, format);
+    vsnprintf(message, n + 1, format, ap);
+    va_end(ap);
+    message[n] = c;
+    return CLIC_ERROR;
+}
+
+#ifdef CLIC_DUMP_BASH_COMPLETION
+static void
+clic_print_bash_completion(const struct clic_ctx *ctx)
+{
+    const struct clic_schema *schema = ctx->schema;
+    const struct clic_scope *scope;
+    const struct clic_param_or_arg *param;
+    const char *program_name = ctx->program_name, *s;
+    struct clic_buffer buffer = {0};
+    size_t j;
+
+    if ((s = strrchr(program_name, '/'))) program_name = s + 1;
+    clic_bprintf(&buffer, "# bash completion for %s, generated by clic.h "
+        "(CLIC_DUMP_BASH_COMPLETION), do not edit\n\n", program_name);
+
+    // options are filtered here rather than by compgen -W, which would expand
+    // them a second time
+    clic_write_shell_function(&buffer, program_name);
+    clic_bprintf(&buffer, "_filter()\n{\n"
+        "    local word\n\n"
+        "    COMPREPLY=()\n"
+        "    for word; do\n"
+        "        [[ $word == \"$cur\"* ]] && COMPREPLY+=(\"$word\")\n"
+        "    done\n"
+        "}\n\n");
+    clic_write_shell_function(&buffer, program_name);
+    clic_bprintf(&buffer, "()\n{\n"
+        "    local cur=${COMP_WORDS[COMP_CWORD]} "
+        "prev=${COMP_WORDS[COMP_CWORD-1]}\n"
+        "    local scope= words=\n\n"
+        "    if [ \"$COMP_CWORD\" -gt 1 ]; then\n"
+        "        scope=${COMP_WORDS[1]}\n"
+        "    fi\n"
+        "    case $scope in\n");
+
+    // subcommands first, the main scope matching anything else
+    for (size_t i = 0; i <= schema->nb_subcommands; i++) {
+        scope = i < schema->nb_subcommands ? &schema->subcommands[i] :
+            &schema->main_scope;
+        clic_bprintf(&buffer, "    %s)\n        case $prev in\n",
+            scope->subcommand_id ? scope->name : "*");
+        for (j = 0; j < scope->nb_params; j++) {
+            param = &scope->params[j];
+            if (param->type == CLIC_FLAG || param->type == CLIC_BOOL)
+                continue;
+            clic_bprintf(&buffer, param->name[1] ? "        --%s)" :
+                "        -%s|--%s)", param->name, param->name);
+            if (param->type == CLIC_STRING &&
+                param->data.restrict_to_declared_options) {
+                clic_bprintf(&buffer, " ");
+                clic_write_shell_function(&buffer, program_name);
+                clic_bprintf(&buffer, "_filter");
+                for (size_t k = 0; k < param->data.nb_string_options; k++) {
+                    clic_bprintf(&buffer, " '");
+                    clic_write_escaped(&buffer,
+                        param->data.string_options[k], "");
+                    clic_bprintf(&buffer, "'");
+                }
+                clic_bprintf(&buffer, ";");
+            }
+            clic_bprintf(&buffer, " return ;;\n");
+        }
+        if (!clic_find_param_or_arg(scope, 0, "conf", 4)) {
+            clic_bprintf(&buffer, "        --conf) return ;;\n");
+        }
+        clic_bprintf(&buffer, "        esac\n        words='");
+        for (j = 0; j < scope->nb_params; j++) {
+            param = &scope->params[j];
+            clic_bprintf(&buffer, param->type == CLIC_BOOL ? "--%s --no-%s " :
+                param->name[1] ? "--%s " : param->type == CLIC_FLAG ? "-%s " :
+                "-%s --%s ", param->name, param->name);
+        }
+        if (!clic_find_param_or_arg(scope, 0, "conf", 4)) {
+            clic_bprintf(&buffer, "--conf ");
+        }
+        if (schema->metadata.version) {
+            clic_bprintf(&buffer, "--version ");
+        }
+        clic_bprintf(&buffer, "--help'\n");
+
+        // positional arguments counted up to the completed word, skipping
+        // the values of parameters
+        for (j = 0; j < scope->nb_args; j++) {
+            if (scope->args[j].type == CLIC_STRING &&
+                scope->args[j].data.restrict_to_declared_options) {
+                break;
+            }
+        }
+        if (j < scope->nb_args) {
+            clic_bprintf(&buffer, "        if [[ $cur != -* ]]; then\n"
+                "            local i arg=0 values=' ");
+            for (j = 0; j < scope->nb_params; j++) {
+                param = &scope->params[j];
+                if (param->type != CLIC_FLAG && param->type != CLIC_BOOL) {
+                    clic_bprintf(&buffer, param->name[1] ? "--%s " :
+                        "-%s --%s ", param->name, param->name);
+                }
+            }
+            if (!clic_find_param_or_arg(scope, 0, "conf", 4)) {
+                clic_bprintf(&buffer, "--conf ");
+            }
+            clic_bprintf(&buffer, "'\n"
+                "            for ((i = %d; i < COMP_CWORD; i++)); do\n"
+                "                if [[ ${COMP_WORDS[i]} != -* ]]; then\n"
+                "                    arg=$((arg + 1))\n"
+                "                elif [[ $values == *\" ${COMP_WORDS[i]} \"* ]]"
+                "; then\n"
+                "                    i=$((i + 1))\n"
+                "                fi\n"
+                "            done\n"
+                "            case $arg in\n", scope->subcommand_id ? 2 : 1);
+            for (j = 0; j < scope->nb_args; j++) {
+                param = &scope->args[j];
+                if (param->type != CLIC_STRING ||
+                    !param->data.restrict_to_declared_options) {
+                    continue;
+                }
+                clic_bprintf(&buffer, "            %zu) ", j);
+                clic_write_shell_function(&buffer, program_name);
+                clic_bprintf(&buffer, "_filter");
+                for (size_t k = 0; k < param->data.nb_string_options; k++) {
+                    clic_bprintf(&buffer, " '");
+                    clic_write_escaped(&buffer,
+                        param->data.string_options[k], "");
+                    clic_bprintf(&buffer, "'");
+                }
+
+                // the first word may also be a subcommand
+                if (!j && !scope->subcommand_id && schema->nb_subcommands) {
+                    clic_bprintf(&buffer, "\n"
+                        "                if [ \"$COMP_CWORD\" -eq 1 ]; then\n"
+                        "                    COMPREPLY+=($(compgen -W '");
+                    for (size_t k = 0; k < schema->nb_subcommands; k++) {
+                        clic_bprintf(&buffer, "%s%s", k ? " " : "",
+                            schema->subcommands[k].name);
+                    }
+                    clic_bprintf(&buffer, "' -- \"$cur\"))\n"
+                        "                fi\n                return ;;\n");
+                } else {
+                    clic_bprintf(&buffer, "; return ;;\n");
+                }
+            }
+            clic_bprintf(&buffer, "            esac\n        fi\n");
+        }
+        clic_bprintf(&buffer, "        ;;\n");
+    }
+    clic_bprintf(&buffer, "    esac\n"
+        "    if [[ $cur == -* ]]; then\n"
+        "        COMPREPLY=($(compgen -W \"$words\" -- \"$cur\"))\n");
+    if (schema->nb_subcommands) {
+        clic_bprintf(&buffer, "    elif [ \"$COMP_CWORD\" -eq 1 ]; then\n"
+            "        COMPREPLY=($(compgen -W '");
+        for (size_t i = 0; i < schema->nb_subcommands; i++) {
+            clic_bprintf(&buffer, "%s%s", i ? " " : "",
+                schema->subcommands[i].name);
+        }
+        clic_bprintf(&buffer, "' -- \"$cur\"))\n");
+    }
+    clic_bprintf(&buffer, "    fi\n}\n\ncomplete -o default -F ");
+    clic_write_shell_function(&buffer, program_name);
+    clic_bprintf(&buffer, " %s\n", program_name);
+    fwrite(buffer.data, 1, buffer.length, stdout);
+    free(buffer.data);
+    exit(EXIT_SUCCESS);
+}
+#endif // CLIC_DUMP_BASH_COMPLETION
+
+#ifndef CLIC_DUMPING
+static void
+clic_print_completions(const struct clic_ctx *ctx, int argc,
+    const char *argv[])
+{
+    size_t length;
+    char *candidates = clic_ctx_complete(ctx, argc, argv, &length);
+
+    fwrite(candidates, 1, length, stdout);
+    free(candidates);
+    exit(EXIT_SUCCESS);
+}
+#endif // !CLIC_DUMPING
+
+#ifdef CLIC_DUMP_FISH_COMPLETION
+static void
+clic_print_fish_completion(const struct clic_ctx *ctx)
+{
+    const struct clic_schema *schema = ctx->schema;
+    const struct clic_scope *scope;
+    const struct clic_param_or_arg *param;
+    const char *program_name = ctx->program_name, *s;
+    struct clic_buffer buffer = {0}, condition = {0};
+    size_t nb_files;
+
+    if ((s = strrchr(program_name, '/'))) program_name = s + 1;
+    clic_bprintf(&buffer, "# fish completion for %s, generated by clic.h "
+        "(CLIC_DUMP_FISH_COMPLETION), do not edit\n", program_name);
+    for (size_t i = 0; i <= schema->nb_subcommands; i++) {
+        scope = i ? &schema->subcommands[i - 1] : &schema->main_scope;
+
+        // the main scope applies until a subcommand is seen
+        free(condition.data);
+        condition = (struct clic_buffer) {0};
+        clic_bprintf(&condition, "complete -c %s", program_name);
+        if (scope->subcommand_id) {
+            clic_bprintf(&condition, " -n '__fish_seen_subcommand_from %s'",
+                scope->name);
+        } else if (schema->nb_subcommands) {
+            clic_bprintf(&condition,
+                " -n 'not __fish_seen_subcommand_from");
+            for (size_t j = 0; j < schema->nb_subcommands; j++) {
+                clic_bprintf(&condition, " %s", schema->subcommands[j].name);
+            }
+            clic_bprintf(&condition, "'");
+            clic_bprintf(&buffer, "\n");
+            for (size_t j = 0; j < schema->nb_subcommands; j++) {
+                clic_bprintf(&buffer, "%s%s -a %s", condition.data,
+                    scope->nb_args || scope->accept_unnamed_arguments ?
+                    "" : " -f", schema->subcommands[j].name);
+                if ((s = schema->subcommands[j].description)) {
+                    clic_bprintf(&buffer, " -d '");
+                    clic_write_escaped(&buffer, s, "'\\");
+                    clic_bprintf(&buffer, "'");
+                }
+                clic_bprintf(&buffer, "\n");
+            }
+        }
+
+        clic_bprintf(&buffer, "\n");
+        for (size_t j = 0; j < scope->nb_params; j++) {
+            param = &scope->params[j];
+            clic_bprintf(&buffer, "%s", condition.data);
+            if (param->type == CLIC_BOOL) {
+                clic_bprintf(&buffer, " -l no-%s", param->name);
+                if ((s = param->description)) {
+                    clic_bprintf(&buffer, " -d '");
+                    clic_write_escaped(&buffer, s, "'\\");
+                    clic_bprintf(&buffer, "'");
+                }
+                clic_bprintf(&buffer, "\n%s", condition.data);
+            }
+            if (!param->name[1] && param->type != CLIC_BOOL) {
+                clic_bprintf(&buffer, " -s %s", param->name);
+            }
+            if (param->name[1] || param->type != CLIC_FLAG) {
+                clic_bprintf(&buffer, " -l %s", param->name);
+            }
+            if (param->type == CLIC_STRING &&
+                param->data.restrict_to_declared_options) {
+                clic_bprintf(&buffer, " -x");
+                clic_write_fish_options(&buffer, param);
+            } else if (param->type == CLIC_STRING ||
+                param->type == CLIC_STRING_LIST) {
+                clic_bprintf(&buffer, " -r -F");
+            } else if (param->type != CLIC_FLAG && param->type != CLIC_BOOL) {
+                clic_bprintf(&buffer, " -x");
+            }
+            if ((s = param->description)) {
+                clic_bprintf(&buffer, " -d '");
+                clic_write_escaped(&buffer, s, "'\\");
+                clic_bprintf(&buffer, "'");
+            }
+            clic_bprintf(&buffer, "\n");
+        }
+
+        // fish cannot tell positional arguments apart, their options are
+        // offered anywhere in the scope, and files only if an argument may
+        // be one
+        nb_files = scope->accept_unnamed_arguments;
+        for (size_t j = 0; j < scope->nb_args; j++) {
+            param = &scope->args[j];
+            nb_files += param->type != CLIC_STRING ||
+                !param->data.restrict_to_declared_options;
+        }
+        for (size_t j = 0; j < scope->nb_args; j++) {
+            param = &scope->args[j];
+            if (param->type != CLIC_STRING ||
+                !param->data.restrict_to_declared_options) {
+                continue;
+            }
+            clic_bprintf(&buffer, "%s%s", condition.data, nb_files ? "" :
+                " -f");
+            clic_write_fish_options(&buffer, param);
+            if ((s = param->description)) {
+                clic_bprintf(&buffer, " -d '");
+                clic_write_escaped(&buffer, s, "'\\");
+                clic_bprintf(&buffer, "'");
+            }
+            clic_bprintf(&buffer, "\n");
+        }
+        if (!clic_find_param_or_arg(scope, 0, "conf", 4)) {
+            clic_bprintf(&buffer, "%s -l conf -r -F "
+                "-d 'read parameters from a file'\n", condition.data);
+        }
+        if (schema->metadata.version) {
+            clic_bprintf(&buffer, "%s -l version -d 'print version'\n",
+                condition.data);
+        }
+        clic_bprintf(&buffer, "%s -l help -d 'print help'\n", condition.data);
+    }
+    fwrite(buffer.data, 1, buffer.length, stdout);
+    free(buffer.data);
+    free(condition.data);
+    exit(EXIT_SUCCESS);
+}
+#endif // CLIC_DUMP_FISH_COMPLETION
+
+#ifndef CLIC_DUMPING
+static void
+clic_print_help(const struct clic_ctx *ctx, const struct clic_scope *scope)
+{
+    struct clic_buffer buffer = {0};
+
+    for (size_t i = 0; i < ctx->nb_help_texts; i++) {
+        if (ctx->help_texts[i].subcommand_id == scope->subcommand_id) {
+            fwrite(ctx->help_texts[i].text, 1, ctx->help_texts[i].length,
+                stdout);
+            exit(EXIT_SUCCESS);
+        }
+    }
+    clic_write_help(ctx, &buffer, scope);
+    fwrite(buffer.data, 1, buffer.length, stdout);
+    free(buffer.data);
+    exit(EXIT_SUCCESS);
+}
+#endif // !CLIC_DUMPING
+
+#ifdef CLIC_DUMP_HELP_C
+static void
+clic_print_help_c(const struct clic_ctx *ctx)
+{
+    const struct clic_schema *schema = ctx->schema;
+    const struct clic_scope *scope;
+    struct clic_buffer buffer = {0}, text;
+    unsigned char c;
+
+    clic_bprintf(&buffer, "// help messages generated by clic.h "
+        "(CLIC_DUMP_HELP_C), do not edit\n\n#include \"clic.h\"\n\n"
+        "const struct clic_help_text clic_help_texts[] = {\n");
+    for (size_t i = 0; i <= schema->nb_subcommands; i++) {
+        scope = i ? &schema->subcommands[i - 1] : &schema->main_scope;
+        text = (struct clic_buffer) {0};
+        clic_write_help(ctx, &text, scope);
+        clic_bprintf(&buffer, "    {\n        %d,\n        \"",
+            scope->subcommand_id);
+        for (size_t j = 0; j < text.length; j++) {
+            switch (c = text.data[j]) {
+            case '\n':
+                clic_bprintf(&buffer, j + 1 < text.length ?
+                    "\\n\"\n        \"" : "\\n");
+                break;
+            case '"':
+            case '\\':
+                clic_bprintf(&buffer, "\\%c", c);
+                break;
+            default:
+                clic_bprintf(&buffer, isprint(c) ? "%c" : "\\%03o", c);
+                break;
+            }
+        }
+        clic_bprintf(&buffer, "\",\n        %zu,\n    },\n", text.length);
+        free(text.data);
+    }
+    clic_bprintf(&buffer, "};\nconst size_t clic_nb_help_texts = %zu;\n",
+        schema->nb_subcommands + 1);
+    fwrite(buffer.data, 1, buffer.length, stdout);
+    free(buffer.data);
+    exit(EXIT_SUCCESS);
+}
+#endif // CLIC_DUMP_HELP_C
+
+#ifdef CLIC_DUMP_OPTIONS
+static void
+clic_print_options(const struct clic_ctx *ctx)
+{
+    const struct clic_schema *schema = ctx->schema;
+    const struct clic_scope *scope;
+    struct clic_buffer buffer = {0};
+
+    clic_bprintf(&buffer, ".SH OPTIONS\n");
+    for (size_t i = 0; i <= schema->nb_subcommands; i++) {
+        scope = i ? &schema->subcommands[i - 1] : &schema->main_scope;
+        if (scope->subcommand_id) {
+            clic_bprintf(&buffer, ".SS ");
+            clic_write_roff(&buffer, scope->name, strlen(scope->name));
+            clic_bprintf(&buffer, "\n");
+            if (scope->description) {
+                clic_write_roff(&buffer, scope->description,
+                    strlen(scope->description));
+                clic_bprintf(&buffer, "\n");
+            }
+        }
+        for (size_t j = 0; j < scope->nb_args; j++) {
+            clic_write_roff_param_or_arg(&buffer, &scope->args[j]);
+        }
+        for (size_t j = 0; j < scope->nb_params; j++) {
+            clic_write_roff_param_or_arg(&buffer, &scope->params[j]);
+        }
+    }
+    fwrite(buffer.data, 1, buffer.length, stdout);
+    free(buffer.data);
+    exit(EXIT_SUCCESS);
+}
+#endif // CLIC_DUMP_OPTIONS
+
+#ifdef CLIC_DUMP_SYNOPSIS
+static void
+clic_print_synopsis(const struct clic_ctx *ctx)
+{
+    const struct clic_schema *schema = ctx->schema;
+    const struct clic_scope *scope;
+    const char *program_name = ctx->program_name;
+    struct clic_buffer buffer = {0};
+    int nb = 0;
+
+    clic_bprintf(&buffer, ".SH SYNOPSIS\n");
+    for (size_t i = 0; i <= schema->nb_subcommands; i++) {
+        scope = i ? &schema->subcommands[i - 1] : &schema->main_scope;
+        if (!scope->subcommand_id && schema->metadata.require_subcommand)
+            continue;
+        clic_bprintf(&buffer, nb++ ? ".br\n.B " : ".B ");
+        clic_write_roff(&buffer, program_name, strlen(program_name));
+        if (scope->subcommand_id) {
+            clic_bprintf(&buffer, " ");
+            clic_write_roff(&buffer, scope->name, strlen(scope->name));
+        }
+        clic_bprintf(&buffer, "\n");
+        if (scope->nb_params) clic_bprintf(&buffer, ".RI [ OPTIONS ]\n");
+        for (size_t j = 0; j < scope->nb_args; j++) {
+            clic_bprintf(&buffer, ".I ");
+            clic_write_roff(&buffer, scope->args[j].name,
+                strlen(scope->args[j].name));
+            clic_bprintf(&buffer, "\n");
+        }
+        if (scope->accept_unnamed_arguments) {
+            clic_bprintf(&buffer, ".RI [ ARGUMENTS ]\n");
+        }
+    }
+    fwrite(buffer.data, 1, buffer.length, stdout);
+    free(buffer.data);
+    exit(EXIT_SUCCESS);
+}
+#endif // CLIC_DUMP_SYNOPSIS
+
+#ifdef CLIC_DUMP_ZSH_COMPLETION
+static void
+clic_print_zsh_completion(const struct clic_ctx *ctx)
+{
+    const struct clic_schema *schema = ctx->schema;
+    const char *program_name = ctx->program_name, *s;
+    struct clic_buffer buffer = {0};
+
+    if ((s = strrchr(program_name, '/'))) program_name = s + 1;
+    clic_bprintf(&buffer, "#compdef %s\n# zsh completion for %s, generated by "
+        "clic.h (CLIC_DUMP_ZSH_COMPLETION), do not edit\n\n", program_name,
+        program_name);
+    clic_write_shell_function(&buffer, program_name);
+    clic_bprintf(&buffer, "()\n{\n");
+    if (schema->nb_subcommands) {
+        clic_bprintf(&buffer, "    if (( CURRENT > 2 )); then\n"
+            "        case $words[2] in\n");
+        for (size_t i = 0; i < schema->nb_subcommands; i++) {
+            clic_bprintf(&buffer, "        %s)\n"
+                "            shift words\n"
+                "            (( CURRENT-- ))\n",
+                schema->subcommands[i].name);
+            clic_write_zsh_arguments(&buffer, schema,
+                &schema->subcommands[i], 12);
+            clic_bprintf(&buffer, "            return\n            ;;\n");
+        }
+        clic_bprintf(&buffer, "        esac\n    fi\n");
+    }
+    clic_write_zsh_arguments(&buffer, schema, &schema->main_scope, 4);
+    clic_bprintf(&buffer, "}\n\n");
+    clic_write_shell_function(&buffer, program_name);
+    clic_bprintf(&buffer, " \"$@\"\n");
+    fwrite(buffer.data, 1, buffer.length, stdout);
+    free(buffer.data);
+    exit(EXIT_SUCCESS);
+}
+#endif // CLIC_DUMP_ZSH_COMPLETION
+
+static int
+clic_read_double(const char *s, double *value)
+{
+    // strict syntax, independent of the locale: [+-]digits[.digits], with
+    // digits on at least one side of the dot, then optionally [eE][+-]digits
+    // returns 0 or an error code, value being correctly rounded
+    static const double powers[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+    static const int steps[] = {1, 3, 6, 9, 13, 16, 19, 23, 26};
+    struct clic_decimal d = { .nb_digits = 0 };
+    const char *c = s;
+    int is_negative = 0, has_digits = 0, has_point = 0, nb_mantissa = 0;
+    int nb_significant = 0;     // digits of d, including the dropped ones
+    int exponent = 0, is_mantissa_truncated = 0, is_exponent_negative, step;
+    uint64_t mantissa = 0, bits;
+    double x;
+
+    // digits, without leading zeros, both as a decimal number and as an
+    // integer mantissa of at most 19 digits
+    if (*c == '+' || *c == '-') {
+        is_negative = *c++ == '-';
+    }
+    for (; (*c >= '0' && *c <= '9') || (*c == '.' && !has_point); c++) {
+        if (*c == '.') {
+            has_point = 1;
+            d.point = nb_significant;
+            continue;
+        }
+        has_digits = 1;
+        if (*c == '0' && !d.nb_digits) {
+            d.point--;
+            continue;
+        }
+        if (nb_mantissa < 19) {
+            mantissa = mantissa * 10 + (*c - '0');
+            nb_mantissa++;
+        } else if (*c != '0') {
+            is_mantissa_truncated = 1;
+        }
+        if (d.nb_digits < (int) sizeof(d.digits)) {
+            d.digits[d.nb_digits++] = *c - '0';
+        } else if (*c != '0') {
+            d.is_truncated = 1;
+        }
+        nb_significant++;
+    }
+    if (!has_digits) {
+        return CLIC_ERROR_INVALID_VALUE;
+    }
+    if (!has_point) {
+        d.point = nb_significant;
+    }
+    if (*c == 'e' || *c == 'E') {
+        c++;
+        is_exponent_negative = *c == '-';
+        if (*c == '+' || *c == '-') {
+            c++;
+        }
+        if (*c < '0' || *c > '9') {
+            return CLIC_ERROR_INVALID_VALUE;
+        }
+        for (; *c >= '0' && *c <= '9'; c++) {
+            if (exponent < 100000) {
+                exponent = exponent * 10 + (*c - '0');
+            }
+        }
+        d.point += is_exponent_negative ? -exponent : exponent;
+    }
+    if (*c) {
+        return CLIC_ERROR_INVALID_VALUE;
+    }
+    while (d.nb_digits && !d.digits[d.nb_digits - 1]) {
+        d.nb_digits--;
+    }
+
+    // exact operands give a correctly rounded result (Clinger's fast path)
+    exponent = d.point - nb_mantissa;
+    if (!d.nb_digits) {
+        *value = is_negative ? -0.0 : 0.0;
+        return 0;
+    }
+    if (FLT_EVAL_METHOD == 0 && !is_mantissa_truncated &&
+        mantissa <= (uint64_t) 1 << 53 && exponent >= -22 && exponent <= 22) {
+        x = (double) mantissa;
+        x = exponent < 0 ? x / powers[-exponent] : x * powers[exponent];
+        *value = is_negative ? -x : x;
+        return 0;
+    }
+
+    // otherwise, scale the decimal number by powers of two to [1, 2), then
+    // take 53 bits of it
+    if (d.point > 310) {
+        return CLIC_ERROR_OUT_OF_RANGE;
+    }
+    if (d.point < -330) {
+        *value = is_negative ? -0.0 : 0.0;
+        return 0;
+    }
+    exponent = 0;
+    while (d.point > 0) {
+        step = d.point >= (int) CLIC_COUNT(steps) ? 27 : steps[d.point];
+        clic_decimal_shift(&d, -step);
+        exponent += step;
+    }
+    while (d.point < 0 || (d.point == 0 && d.digits[0] < 5)) {
+        step = -d.point >= (int) CLIC_COUNT(steps) ? 27 : steps[-d.point];
+        clic_decimal_shift(&d, step);
+        exponent -= step;
+    }
+    exponent--;
+    if (exponent < -1022) {
+        // subnormal
+        clic_decimal_shift(&d, exponent + 1022);
+        exponent = -1022;
+    }
+    if (exponent > 1023) {
+        return CLIC_ERROR_OUT_OF_RANGE;
+    }
+    clic_decimal_shift(&d, 53);
+    mantissa = 0;
+    for (int i = 0; i < d.point; i++) {
+        mantissa = mantissa * 10 + (i < d.nb_digits ? d.digits[i] : 0);
+    }
+    if (d.point >= 0 && d.point < d.nb_digits) {
+        // round half to even
+        if (d.digits[d.point] == 5 && d.point + 1 == d.nb_digits) {
+            mantissa += d.is_truncated ||
+                (d.point > 0 && d.digits[d.point - 1] % 2);
+        } else {
+            mantissa += d.digits[d.point] >= 5;
+        }
+    }
+    if (mantissa == (uint64_t) 1 << 53) {
+        mantissa >>= 1;
+        if (++exponent > 1023) {
+            return CLIC_ERROR_OUT_OF_RANGE;
+        }
+    }
+    if (!(mantissa >> 52)) {
+        exponent = -1023;
+    }
+    bits = (mantissa & (((uint64_t) 1 << 52) - 1)) |
+        (uint64_t) (exponent + 1023) << 52 |
+        (uint64_t) is_negative << 63;
+    memcpy(value, &bits, sizeof(bits));
+    return 0;
+}
+
+static void *
+clic_rebase(const struct clic_ctx *ctx, void *results, const void *variable)
+{
+    // variables lying in the results prototype are moved to results
+    uintptr_t start = (uintptr_t) ctx->results_prototype;
+    uintptr_t address = (uintptr_t) variable;
+
+    if (address < start || address - start >= ctx->results_size) {
+        return (void *) variable;
+    }
+    return (char *) results + (address - start);
+}
+
+static void
+clic_release_files(struct clic_kept_files *kept_files, const void *results,
+    int all)
+{
+    // releases the files kept for results (or all of them), taking the whole
+    // list so that concurrent releases never see the same file
+    struct clic_kept_file *kept, *next;
+
+    kept = atomic_exchange(&kept_files->head, NULL);
+    for (; kept; kept = next) {
+        next = kept->next;
+        if (all || kept->results == results) {
+            free(kept->copy);
+            clic_unmap_file(&kept->file);
+            free(kept);
+        } else {
+            clic_keep_file(kept_files, kept);
+        }
+    }
+}
+
+static void
+clic_reset_status(struct clic_status *status)
+{
+    status->state = CLIC_PARSED;
+    status->subcommand_id = 0;
+    status->nb_processed_arguments = 0;
+    status->error = CLIC_ERROR_NONE;
+    status->token = -1;
+    if (status->message && status->message_size) {
+        status->message[0] = '\0';
+    }
+}
+
+static void
+clic_set_defaults(const struct clic_ctx *ctx, void *results,
+    const struct clic_scope *scope)
+{
+    const struct clic_param_or_arg *param;
+    struct clic_param_or_arg bound;
+
+    for (size_t i = 0; i < scope->nb_params; i++) {
+        param = clic_bind(ctx, results, &scope->params[i], &bound);
+        switch (param->type) {
+        case CLIC_FLAG:
+        case CLIC_BOOL:
+            if (param->data.scalar_variable) {
+                clic_set_flag_or_bool(param->data.scalar_variable,
+                    param->data.scalar_default_value, param->data.mask);
+            }
+            break;
+        case CLIC_INT:
+            if (param->data.scalar_variable) {
+                *param->data.scalar_variable = param->data.scalar_default_value;
+            }
+            break;
+        case CLIC_STRING:
+            if (param->data.string_variable) {
+                *param->data.string_variable = param->data.string_default_value;
+            }
+            break;
+        case CLIC_LONG:
+        case CLIC_INT64:
+        case CLIC_UINT64:
+        case CLIC_SIZE:
+            clic_set_integer(param, param->data.signed_default_value,
+                param->data.unsigned_default_value);
+            break;
+        case CLIC_INT_LIST:
+        case CLIC_STRING_LIST:
+            // previous lists are the caller's, see clic_ctx_free_results
+            if (param->data.list_variable && param->data.list_count) {
+                if (param->type == CLIC_INT_LIST) {
+                    *(int **) param->data.list_variable = NULL;
+                } else {
+                    *(const char ***) param->data.list_variable = NULL;
+                }
+                *param->data.list_count = 0;
+            }
+            break;
+        case CLIC_DOUBLE:
+            if (param->data.double_variable) {
+                *param->data.double_variable = param->data.double_default_value;
+            }
             break;
         }
     }
-    if (!active_scope.subcommand_id &&
-        clic_globals.metadata.require_subcommand) {
-        if (argc > 1 && !strcmp(argv[1], "--help")) {
-            clic_print_help(clic_globals.main_scope);
+}
+
+static void
+clic_set_flag_or_bool(int *variable, int value, int mask)
+{
+    if (mask) {
+        if (value) {
+            *variable |= mask;
         } else {
-            clic_fail("subcommand not found");
+            *variable &= ~mask;
         }
+    } else {
+        *variable = value;
+    };
+}
+
+static void
+clic_set_integer(const struct clic_param_or_arg *param_or_arg,
+    int64_t signed_value, uint64_t unsigned_value)
+{
+    // the value has already been checked to fit in the variable type
+    void *variable = param_or_arg->data.integer_variable;
+
+    switch (param_or_arg->type) {
+    case CLIC_INT:
+        if (param_or_arg->data.scalar_variable) {
+            *param_or_arg->data.scalar_variable = (int) signed_value;
+        }
+        return;
+    case CLIC_LONG:
+        if (variable) *(long *) variable = (long) signed_value;
+        return;
+    case CLIC_INT64:
+        if (variable) *(int64_t *) variable = signed_value;
+        return;
+    case CLIC_UINT64:
+        if (variable) *(uint64_t *) variable = unsigned_value;
+        return;
+    case CLIC_SIZE:
+        if (variable) *(size_t *) variable = (size_t) unsigned_value;
+        return;
+    default:
+        return;
     }
-    if (subcommand_id) {
-        *subcommand_id = active_scope.subcommand_id;
-    }
+}
 
-    // eat parameters
-    while ((s = argv[1 + nb_processed_arguments])) {
-        if (!strcmp(s, "--")) {
-            nb_processed_arguments++;
-            break;
+static int
+clic_split_line(char *line, const char *argv[], int argv_size, int *argc,
+    struct clic_status *status)
+{
+    // shell-like splitting, in place as a token is never longer than its
+    // source: blanks separate tokens, a backslash escapes the next character
+    // (or joins lines), single quotes keep everything literal, double quotes
+    // only allow escaping '"' and '\', and '#' starts a comment
+    // token indices reported in status are shifted by one, for argv[0]
+    char *r = line, *w, quote;
+    int is_last;
+
+    for (*argc = 0; ; (*argc)++) {
+        while (isspace((unsigned char) *r) || (*r == '\\' && r[1] == '\n')) {
+            r += *r == '\\' ? 2 : 1;
         }
-        if (s[0] == '-' && isalpha(s[1])) {
-            name = s + 1;
-        } else if (!strncmp(s, "--no-", 5)) {
-            name = s + 5;
-        } else if (!strncmp(s, "--", 2)) {
-            name = s + 2;
-        } else {
-            // not a parameter
+        if (!*r || *r == '#') {
             break;
         }
-        found = 0;
-        clic_list_for(active_scope.params, param, clic_param_or_arg) {
-            if (strcmp(name, param->name))
-                continue;
-            nb_processed_arguments += clic_parse_param_or_arg(*param, s,
-                argv[1 + nb_processed_arguments + 1]);
-            found = 1;
-            break;
+        if (*argc >= argv_size - 1) {
+            return clic_error(status, CLIC_ERROR_TOO_MANY_TOKENS, 1 + *argc,
+                "too many tokens (at most %d)", argv_size - 1);
         }
-        if (!found) {
-            // TODO: also handle configuration files (--conf FILE) ?
-            if (!strcmp(s, "--help")) {
-                clic_print_help(active_scope);
-            } else if (!strcmp(s, "--version") &&
-                clic_globals.metadata.version) {
-                printf("%s\n", clic_globals.metadata.version);
-                exit(EXIT_SUCCESS);
+        argv[*argc] = w = r;
+        for (quote = 0; *r && (quote || !isspace((unsigned char) *r)); r++) {
+            if (quote && *r == quote) {
+                quote = 0;
+            } else if (!quote && (*r == '\'' || *r == '"')) {
+                quote = *r;
+            } else if (*r == '\\' && quote != '\'' && (!quote ||
+                r[1] == '"' || r[1] == '\\' || r[1] == '\n')) {
+                if (!*++r) {
+                    return clic_error(status, CLIC_ERROR_BAD_QUOTING,
+                        1 + *argc, "trailing backslash");
+                } else if (*r != '\n') {
+                    *w++ = *r;
+                }
             } else {
-                clic_fail("unknown parameter '%s'", name);
+                *w++ = *r;
             }
         }
-    }
-
-    // eat named arguments
-    clic_list_for(active_scope.args, arg, clic_param_or_arg) {
-        if (!(s = argv[1 + nb_processed_arguments])) {
-            clic_fail("missing required argument '%s'", arg->name);
+        if (quote) {
+            return clic_error(status, CLIC_ERROR_BAD_QUOTING, 1 + *argc,
+                "unterminated %s quote", quote == '"' ? "double" : "single");
+        }
+        is_last = !*r;
+        *w = '\0';
+        if (is_last) {
+            (*argc)++;
+            break;
         }
-        nb_processed_arguments += clic_parse_param_or_arg(*arg, s, NULL);
+        r++;
     }
+    argv[*argc] = NULL;
+    return 0;
+}
 
-    // check if there are unnamed arguments
-    if (!active_scope.accept_unnamed_arguments &&
-        1 + nb_processed_arguments < argc) {
-        clic_fail("too many arguments");
-    }
+static const char *
+clic_suggest_param(const struct clic_ctx *ctx,
+    const struct clic_scope *scope, const char *name, size_t len,
+    int negated)
+{
+    // nearest long parameter (boolean if negated) or built-in option of scope
+    // to name, or NULL
+    const struct clic_param_or_arg *param;
+    struct clic_nearest nearest;
 
-    // cleanup
-    clic_list_safe_for(clic_globals.flag_names, flag_name, clic_flag_name) {
-        free(flag_name);
+    clic_nearest_init(&nearest, name, len);
+    for (size_t i = 0; nearest.distance && i < scope->nb_params; i++) {
+        param = &scope->params[i];
+        if (param->name[1] && (!negated || param->type == CLIC_BOOL)) {
+            clic_nearest_add(&nearest, param->name);
+        }
     }
-    clic_list_safe_for(clic_globals.subcommand_scopes, scope, clic_scope) {
-        clic_list_safe_for(scope->params, param_or_arg, clic_param_or_arg) {
-            clic_list_safe_for(param_or_arg->data.string_options, string_option,
-                clic_string_option) {
-                free(string_option);
-            }
-            free(param_or_arg);
+    if (nearest.distance && !negated) {
+        if (ctx->allow_conf &&
+            !clic_find_param_or_arg(scope, 0, "conf", 4)) {
+            clic_nearest_add(&nearest, "conf");
         }
-        clic_list_safe_for(scope->args, param_or_arg, clic_param_or_arg) {
-            clic_list_safe_for(param_or_arg->data.string_options, string_option,
-                clic_string_option) {
-                free(string_option);
-            }
-            free(param_or_arg);
+        if (ctx->schema->metadata.version) {
+            clic_nearest_add(&nearest, "version");
         }
-        free(scope);
+        clic_nearest_add(&nearest, "help");
     }
-#endif // CLIC_DUMP_*
-
-    return nb_processed_arguments;
+    return nearest.name;
 }
 
-static struct clic_elem *
-clic_add_list_elem(struct clic_list *list, size_t size)
+static const char *
+clic_suggest_subcommand(const struct clic_schema *schema, const char *name)
 {
-    struct clic_elem *res = malloc(size);
-    if (list->start) {
-        list->end->next = res;
-    } else {
-        list->start = res;
+    // nearest subcommand to name, or NULL
+    struct clic_nearest nearest;
+
+    clic_nearest_init(&nearest, name, strlen(name));
+    for (size_t i = 0; nearest.distance && i < schema->nb_subcommands; i++) {
+        clic_nearest_add(&nearest, schema->subcommands[i].name);
     }
-    list->end = res;
-    return res;
+    return nearest.name;
 }
 
-static void
-clic_add_param_or_arg(int subcommand_id, const char *name,
-    const char *description, enum clic_type type, int is_required,
-    union clic_type_specific_data data)
+static size_t
+clic_trie_insert(struct clic_arena *arena, struct clic_trie *trie, size_t node,
+    const char *s, size_t len)
 {
-    clic_check_initialized_and_not_parsed();
-    clic_check_name_correctness(name);
-    struct clic_scope *scope = clic_check_subcommmand_declaration(subcommand_id,
-        NULL, 1);
-    struct clic_list *list = is_required ? &scope->args : &scope->params;
-    clic_check_param_or_arg_declaration(*list, name, 0);
-    struct clic_param_or_arg *param_or_arg = (struct clic_param_or_arg *)
-        clic_add_list_elem(list, sizeof(*param_or_arg));
-    *param_or_arg = (struct clic_param_or_arg) {
-        .name = name,
-        .description = description,
-        .type = type,
-        .is_required = is_required,
-        .data = data,
-    };
-}
+    // returns the node reached from node through s, creating the missing ones
+    // with children sorted by character
+    size_t prev, next;
+    unsigned char c;
 
-static void
-clic_add_param_or_arg_string_option(int subcommand_id, int is_required,
-    const char *param_or_arg_name, const char *value)
-{
-    clic_check_initialized_and_not_parsed();
-    clic_check_name_correctness(param_or_arg_name);
-    struct clic_scope *scope = clic_check_subcommmand_declaration(subcommand_id,
-        NULL, 1);
-    struct clic_list *list = is_required ? &scope->args : &scope->params;
-    struct clic_param_or_arg *param_or_arg =
-        clic_check_param_or_arg_declaration(*list, param_or_arg_name, 1);
-    if (param_or_arg->type != CLIC_STRING ||
-        !param_or_arg->data.restrict_to_declared_options) {
-        clic_fail("parameter or argument '%s' is not a restricted-input string, "
-            "cannot declare an option '%s' for it",
-            param_or_arg_name, value);
+    if (!trie->nb_nodes) {
+        trie->nodes = clic_arena_grow(arena, NULL, 0, sizeof(*trie->nodes));
+        trie->nodes[trie->nb_nodes++] = (struct clic_trie_node) {0};
     }
-    struct clic_string_option *string_option = (struct clic_string_option *)
-        clic_add_list_elem(&param_or_arg->data.string_options,
-            sizeof(*string_option));
-    *string_option = (struct clic_string_option) {
-        .param_or_arg_name = param_or_arg_name,
-        .value = value,
-    };
+    for (size_t i = 0; i < len; i++) {
+        c = s[i];
+        prev = 0;
+        next = trie->nodes[node].child;
+        while (next && trie->nodes[next].c < c) {
+            prev = next;
+            next = trie->nodes[next].sibling;
+        }
+        if (!next || trie->nodes[next].c != c) {
+            trie->nodes = clic_arena_grow(arena, trie->nodes, trie->nb_nodes,
+                sizeof(*trie->nodes));
+            trie->nodes[trie->nb_nodes] = (struct clic_trie_node) {
+                .sibling = (uint32_t) next,
+                .c = c,
+            };
+            next = trie->nb_nodes++;
+            if (prev) {
+                trie->nodes[prev].sibling = (uint32_t) next;
+            } else {
+                trie->nodes[node].child = (uint32_t) next;
+            }
+        }
+        node = next;
+    }
+    return node;
 }
 
-static void
-clic_check_initialized_and_not_parsed(void)
+static size_t
+clic_trie_walk(const struct clic_trie *trie, size_t node, const char *s,
+    size_t len)
 {
-    if (!clic_globals.is_init) {
-        clic_fail("clic has not been initialized");
-    } else if (clic_globals.is_parsed) {
-        clic_fail("clic has already parsed command line arguments");
+    // returns the node reached from node through s, or SIZE_MAX
+    size_t next;
+
+    for (size_t i = 0; i < len && node != SIZE_MAX; i++) {
+        next = trie->nb_nodes ? trie->nodes[node].child : 0;
+        while (next && trie->nodes[next].c < (unsigned char) s[i]) {
+            next = trie->nodes[next].sibling;
+        }
+        node = next && trie->nodes[next].c == (unsigned char) s[i] ? next :
+            SIZE_MAX;
     }
+    return node;
 }
 
 static void
-clic_check_name_correctness(const char *name)
+clic_trie_write(const struct clic_trie *trie, size_t node,
+    struct clic_buffer *path, struct clic_buffer *b)
 {
-    if (!name || !isalpha(*name)) {
-        clic_fail("invalid name '%s'", name ? name : "NULL");
+    // write the words below node in order, one per line, path holding the
+    // characters leading to node
+    if (node == SIZE_MAX || !trie->nb_nodes) {
+        return;
     }
-    for (const char *c = name; *c; c++) {
-        if (!(isalpha(*c) || *c == '-' || *c == '_')) {
-            clic_fail("invalid name '%s'", name);
+    if (trie->nodes[node].is_word) {
+        clic_bprintf(b, "%.*s\n", (int) path->length, path->data);
+    }
+    for (size_t child = trie->nodes[node].child; child;
+        child = trie->nodes[child].sibling) {
+        if (!clic_bprintf(path, "%c", trie->nodes[child].c)) {
+            return;
         }
+        clic_trie_write(trie, child, path, b);
+        path->length--;
     }
 }
 
-static struct clic_param_or_arg *
-clic_check_param_or_arg_declaration(struct clic_list list,
-    const char *param_or_arg_name, int should_be_declared)
+static const char *
+clic_type_name(enum clic_type type)
 {
-    // if should_be_declared, return pointer
-    // else, return NULL
-    clic_check_name_correctness(param_or_arg_name);
-    clic_list_for(list, param_or_arg, clic_param_or_arg) {
-        if (!strcmp(param_or_arg_name, param_or_arg->name)) {
-            if (!should_be_declared) {
-                clic_fail("parameter/argument '%s' has already been declared in this scope",
-                    param_or_arg_name);
-            }
-            return param_or_arg;
-        }
-    }
-    if (should_be_declared) {
-        clic_fail("parameter/argument '%s' has not been declared in this scope",
-            param_or_arg_name);
+    switch (type) {
+    case CLIC_FLAG: return "flag";
+    case CLIC_BOOL: return "boolean";
+    case CLIC_INT: return "integer";
+    case CLIC_STRING: return "string";
+    case CLIC_LONG: return "integer";
+    case CLIC_INT64: return "integer";
+    case CLIC_UINT64: return "unsigned";
+    case CLIC_SIZE: return "size";
+    case CLIC_INT_LIST: return "integers";
+    case CLIC_STRING_LIST: return "strings";
+    case CLIC_DOUBLE: return "number";
     }
     return NULL;
 }
 
-static struct clic_scope *
-clic_check_subcommmand_declaration(int subcommand_id,
-    const char *subcommand_name, int should_be_declared)
+static void
+clic_unmap_file(const struct clic_file *file)
 {
-    // if should_be_declared, only subcommand_id is checked, return pointer
-    // else, return NULL
-    if (subcommand_id) {
-        if (should_be_declared) {
-            clic_list_for(clic_globals.subcommand_scopes, scope, clic_scope) {
-                if (subcommand_id == scope->subcommand_id) {
-                    return scope;
-                }
-            }
-            clic_fail("subcommand identifier %d has not been declared",
-                subcommand_id);
-        } else {
-            clic_check_name_correctness(subcommand_name);
-            clic_list_for(clic_globals.subcommand_scopes, scope, clic_scope) {
-                if (subcommand_id == scope->subcommand_id ||
-                    !strcmp(subcommand_name, scope->name)) {
-                    clic_fail("subcommand identifier %d or name '%s' has already been declared",
-                        subcommand_id, subcommand_name);
-                }
-            }
-        }
-    } else {
-        if (should_be_declared) {
-            return &clic_globals.main_scope;
-        } else {
-            clic_fail("0 is already implicitely used as the main scope identifier");
-        }
+#if CLIC_MMAP
+    if (file->is_mapped) {
+        munmap(file->data, file->size);
+        return;
     }
-    return NULL;
+#endif // CLIC_MMAP
+    free(file->data);
 }
 
 static void
-clic_fail(const char *error_message, ...)
+clic_write_abbreviations(const struct clic_scope *scope, const char *ns,
+    const char *s, size_t len, struct clic_buffer *b)
 {
-    va_list ap;
-    fprintf(stderr, "clic: ");
-    va_start(ap, error_message);
-    vfprintf(stderr, error_message, ap);
-    va_end(ap);
-    fprintf(stderr, "\n");
-    exit(EXIT_FAILURE);
+    // writes the words of namespace ns starting with the len first characters
+    // of s in b, as a comma separated list
+    const struct clic_trie *trie = &scope->completions;
+    struct clic_buffer path = { .is_fallible = 1 };
+    struct clic_buffer words = { .is_fallible = 1 };
+
+    clic_bprintf(&path, "%.*s", (int) len, s);
+    clic_trie_write(trie, clic_trie_walk(trie, clic_trie_walk(trie, 0, ns,
+        strlen(ns)), s, len), &path, &words);
+    for (char *word = words.data, *end; word &&
+        (end = strchr(word, '\n')); word = end + 1) {
+        clic_bprintf(b, "%s%.*s", word == words.data ? "" : ", ",
+            (int) (end - word), word);
+    }
+    if (path.has_failed || words.has_failed) {
+        b->has_failed = 1;
+    }
+    free(path.data);
+    free(words.data);
 }
 
-static int
-clic_parse_param_or_arg(struct clic_param_or_arg param_or_arg, const char *arg1,
-    const char *arg2)
+static void
+clic_write_default_value(struct clic_buffer *b,
+    const struct clic_param_or_arg *param_or_arg)
 {
-    // arg1 and arg2 are command line arguments
-    // returns the number of them used to parse param_or_arg
-    // check type correctness, value correctness, store in variable
+    char number[32];
+    double x, y;
 
-    const char *s = param_or_arg.is_required ? arg1 : arg2;
-    int found;
-
-    switch (param_or_arg.type) {
+    switch (param_or_arg->type) {
     case CLIC_FLAG:
-        if (arg1[1] == '-') {
-            clic_fail("bad syntax to set flag '%s'", param_or_arg.name);
-        }
-        if (param_or_arg.data.scalar_variable) {
-            clic_set_flag_or_bool(param_or_arg.data.scalar_variable, 1,
-                param_or_arg.data.mask);
-        }
-        return 1;
+    case CLIC_INT_LIST:
+    case CLIC_STRING_LIST:
+        break;
     case CLIC_BOOL:
-        if (strncmp(arg1, "--", 2)) {
-            clic_fail("bad syntax to set bool '%s'", param_or_arg.name);
-        }
-        if (param_or_arg.data.scalar_variable) {
-            clic_set_flag_or_bool(param_or_arg.data.scalar_variable,
-                strncmp(arg1, "--no-", 5), param_or_arg.data.mask);
-        }
-        return 1;
+        clic_bprintf(b, "--%s%s",
+            param_or_arg->data.scalar_default_value ? "" : "no-",
+            param_or_arg->name);
+        break;
     case CLIC_INT:
+        clic_bprintf(b, "%d", param_or_arg->data.scalar_default_value);
+        break;
     case CLIC_STRING:
-        if (!param_or_arg.is_required && !arg2) {
-            clic_fail("missing required value for parameter '%s'",
-                param_or_arg.name);
-        } else if (!param_or_arg.is_required && (strncmp(arg1, "--", 2) ||
-            !strncmp(arg1, "--no-", 5))) {
-            clic_fail("bad syntax to set %s '%s'",
-                param_or_arg.type == CLIC_INT ? "integer" : "string",
-                param_or_arg.name);
-        }
-        if (param_or_arg.type == CLIC_INT) {
-            if (atoi(s) == 0 && strcmp(s, "0")) {
-                clic_fail("expected an integer (%s), got '%s'",
-                    param_or_arg.name, s);
-            }
-            if (param_or_arg.data.scalar_variable) {
-                *param_or_arg.data.scalar_variable = atoi(s);
-            }
-        } else {
-            if (param_or_arg.data.restrict_to_declared_options) {
-                found = 0;
-                clic_list_for(param_or_arg.data.string_options, string_option,
-                    clic_string_option) {
-                    if (strcmp(s, string_option->value))
-                        continue;
-                    found = 1;
-                    break;
-                }
-                if (!found) {
-                    clic_fail("'%s' is not an acceptable value for %s", s,
-                        param_or_arg.name);
+        clic_bprintf(b, "%s", param_or_arg->data.string_default_value);
+        break;
+    case CLIC_LONG:
+    case CLIC_INT64:
+        clic_bprintf(b, "%lld",
+            (long long) param_or_arg->data.signed_default_value);
+        break;
+    case CLIC_UINT64:
+    case CLIC_SIZE:
+        clic_bprintf(b, "%llu",
+            (unsigned long long) param_or_arg->data.unsigned_default_value);
+        break;
+    case CLIC_DOUBLE:
+        // shortest representation reading back to the default value, the
+        // decimal point of the locale being replaced by a dot
+        x = param_or_arg->data.double_default_value;
+        for (int precision = 1; precision <= 17; precision++) {
+            snprintf(number, sizeof(number), "%.*g", precision, x);
+            for (char *c = number; *c; c++) {
+                if (!isalnum((unsigned char) *c) && *c != '-' && *c != '+') {
+                    *c = '.';
                 }
             }
-            if (param_or_arg.data.string_variable) {
-                *param_or_arg.data.string_variable = s;
+            if (x != x || x - x != 0 || (!clic_read_double(number, &y) &&
+                y == x)) {
+                break;
             }
         }
-        return param_or_arg.is_required ? 1 : 2;
+        clic_bprintf(b, "%s", number);
+        break;
     }
-    return 0;
 }
 
+#if defined(CLIC_DUMP_BASH_COMPLETION) || defined(CLIC_DUMP_ZSH_COMPLETION) || \
+    defined(CLIC_DUMP_FISH_COMPLETION)
+static void
+clic_write_escaped(struct clic_buffer *b, const char *s, const char *specials)
+{
+    // s inside a single-quoted shell word, specials being preceded by a
+    // backslash and newlines replaced by spaces
+    for (; *s; s++) {
+        if (*s == '\n') {
+            clic_bprintf(b, " ");
+        } else if (strchr(specials, *s)) {
+            clic_bprintf(b, "\\%c", *s);
+        } else if (*s == '\'') {
+            clic_bprintf(b, "'\\''");
+        } else {
+            clic_bprintf(b, "%c", *s);
+        }
+    }
+}
+#endif // CLIC_DUMP_*_COMPLETION
+
+#ifdef CLIC_DUMP_FISH_COMPLETION
+static void
+clic_write_fish_options(struct clic_buffer *b,
+    const struct clic_param_or_arg *param_or_arg)
+{
+    // -a option listing the options of param_or_arg, which fish splits and
+    // expands, hence each option being escaped before the whole list
+    struct clic_buffer options = {0};
+
+    for (size_t i = 0; i < param_or_arg->data.nb_string_options; i++) {
+        clic_bprintf(&options, i ? " " : "");
+        clic_write_escaped(&options, param_or_arg->data.string_options[i],
+            " \t\"'\\$()*?[]{}<>&|;#~%");
+    }
+    clic_bprintf(b, " -a '");
+    clic_write_escaped(b, options.data ? options.data : "", "'\\");
+    clic_bprintf(b, "'");
+    free(options.data);
+}
+#endif // CLIC_DUMP_FISH_COMPLETION
+
 static void
-clic_print_help(struct clic_scope scope)
+clic_write_help(const struct clic_ctx *ctx, struct clic_buffer *b,
+    const struct clic_scope *scope)
 {
+    const struct clic_schema *schema = ctx->schema;
+    const struct clic_scope *subcommand;
     const char *program_name, *s;
 
     // metadata
-    printf("%s", program_name = clic_globals.main_scope.name);
-    if ((s = clic_globals.metadata.version)) printf(" %s", s);
-    if ((s = clic_globals.metadata.license)) printf(" (license: %s)", s);
-    printf("\n");
-    if ((s = clic_globals.main_scope.description)) printf("%s\n", s);
+    program_name = ctx->program_name ? ctx->program_name : "";
+    clic_bprintf(b, "%s", program_name);
+    if ((s = schema->metadata.version)) clic_bprintf(b, " %s", s);
+    if ((s = schema->metadata.license)) clic_bprintf(b, " (license: %s)", s);
+    clic_bprintf(b, "\n");
+    if ((s = schema->main_scope.description)) clic_bprintf(b, "%s\n", s);
 
     // usage, subcommands
-    printf("\nUSAGE\n");
-    if (scope.subcommand_id || !clic_globals.metadata.require_subcommand) {
-        printf("%*s%s", CLIC_PADDING_1, "", program_name);
-        if (scope.subcommand_id) printf(" %s", scope.name);
-        if (scope.params.start) printf(" [OPTIONS]");
-        clic_list_for(scope.args, arg, clic_param_or_arg) {
-            printf(" %s", arg->name);
-        }
-        if (scope.accept_unnamed_arguments) printf(" [ARGUMENTS]");
-        printf("\n");
-    }
-    if (!scope.subcommand_id && clic_globals.subcommand_scopes.start) {
-        printf("%*s%s SUBCOMMAND ... (see %s SUBCOMMAND --help)\n",
+    clic_bprintf(b, "\nUSAGE\n");
+    if (scope->subcommand_id || !schema->metadata.require_subcommand) {
+        clic_bprintf(b, "%*s%s", CLIC_PADDING_1, "", program_name);
+        if (scope->subcommand_id) clic_bprintf(b, " %s", scope->name);
+        if (scope->nb_params) clic_bprintf(b, " [OPTIONS]");
+        for (size_t i = 0; i < scope->nb_args; i++) {
+            clic_bprintf(b, " %s", scope->args[i].name);
+        }
+        if (scope->accept_unnamed_arguments) clic_bprintf(b, " [ARGUMENTS]");
+        clic_bprintf(b, "\n");
+    }
+    if (!scope->subcommand_id && schema->nb_subcommands) {
+        clic_bprintf(b, "%*s%s SUBCOMMAND ... (see %s SUBCOMMAND --help)\n",
             CLIC_PADDING_1, "", program_name, program_name);
-        printf("\nSUBCOMMANDS\n");
-        clic_list_for(clic_globals.subcommand_scopes, subcommand, clic_scope) {
-            printf("%*s%-*s", CLIC_PADDING_1, "", CLIC_PADDING_2,
+        clic_bprintf(b, "\nSUBCOMMANDS\n");
+        for (size_t i = 0; i < schema->nb_subcommands; i++) {
+            subcommand = &schema->subcommands[i];
+            clic_bprintf(b, "%*s%-*s", CLIC_PADDING_1, "", CLIC_PADDING_2,
                 s = subcommand->name);
             if (subcommand->description) {
                 if (strlen(s) >= CLIC_PADDING_2)
-                    printf("\n%*s", CLIC_PADDING_1 + CLIC_PADDING_2, "");
-                printf("%s", subcommand->description);
+                    clic_bprintf(b, "\n%*s",
+                        CLIC_PADDING_1 + CLIC_PADDING_2, "");
+                clic_bprintf(b, "%s", subcommand->description);
             }
-            printf("\n");
+            clic_bprintf(b, "\n");
         }
     }
 
     // named arguments, parameters
-    if (scope.args.start) {
-        printf("\nNAMED ARGUMENTS\n");
-        clic_list_for(scope.args, arg, clic_param_or_arg) {
-            clic_print_help_param_or_arg(*arg);
+    if (scope->nb_args) {
+        clic_bprintf(b, "\nNAMED ARGUMENTS\n");
+        for (size_t i = 0; i < scope->nb_args; i++) {
+            clic_write_help_param_or_arg(b, &scope->args[i]);
         }
     }
-    if (scope.params.start) {
-        printf("\nOPTIONS\n");
-        clic_list_for(scope.params, param, clic_param_or_arg) {
-            clic_print_help_param_or_arg(*param);
+    if (scope->nb_params) {
+        clic_bprintf(b, "\nOPTIONS\n");
+        for (size_t i = 0; i < scope->nb_params; i++) {
+            clic_write_help_param_or_arg(b, &scope->params[i]);
         }
     }
-
-    exit(EXIT_SUCCESS);
 }
 
 static void
-clic_print_help_param_or_arg(struct clic_param_or_arg param_or_arg)
+clic_write_help_param_or_arg(struct clic_buffer *b,
+    const struct clic_param_or_arg *param_or_arg)
 {
     const char *s;
     enum clic_type type;
     int nb;
 
     // syntax
-    printf("%*s", CLIC_PADDING_1, "");
-    s = param_or_arg.name;
+    clic_bprintf(b, "%*s", CLIC_PADDING_1, "");
+    s = param_or_arg->name;
     nb = 0;
-    switch (type = param_or_arg.type) {
+    switch (type = param_or_arg->type) {
     case CLIC_FLAG:
-        nb += printf("-%s", s);
+        nb += clic_bprintf(b, "-%s", s);
         break;
     case CLIC_BOOL:
-        nb += printf("--%s, --no-%s", s, s);
+        nb += clic_bprintf(b, "--%s, --no-%s", s, s);
         break;
     case CLIC_INT:
     case CLIC_STRING:
-        nb += printf(param_or_arg.is_required ? "%s" : "--%s value", s);
+    case CLIC_LONG:
+    case CLIC_INT64:
+    case CLIC_UINT64:
+    case CLIC_SIZE:
+    case CLIC_INT_LIST:
+    case CLIC_STRING_LIST:
+    case CLIC_DOUBLE:
+        if (param_or_arg->is_required) {
+            nb += clic_bprintf(b, "%s", s);
+        } else if (isalpha((unsigned char) s[0]) && !s[1]) {
+            // also accepted as -n value and -nvalue
+            nb += clic_bprintf(b, "-%s, --%s value", s, s);
+        } else {
+            nb += clic_bprintf(b, "--%s value", s);
+        }
         break;
     }
 
     // type and description
     if (nb >= CLIC_PADDING_2) {
-        printf("\n%*s", CLIC_PADDING_1 + CLIC_PADDING_2, "");
+        clic_bprintf(b, "\n%*s", CLIC_PADDING_1 + CLIC_PADDING_2, "");
     } else {
-        printf("%*s", CLIC_PADDING_2 - nb, "");
+        clic_bprintf(b, "%*s", CLIC_PADDING_2 - nb, "");
     }
-    printf("%-*s", CLIC_PADDING_3,
-        type == CLIC_FLAG ? "flag" :
-        type == CLIC_BOOL ? "boolean" :
-        type == CLIC_INT ? "integer" :
-        "string");
-    if ((s = param_or_arg.description)) printf("%s", s);
-    printf("\n");
+    clic_bprintf(b, "%-*s", CLIC_PADDING_3, clic_type_name(type));
+    if ((s = param_or_arg->description)) clic_bprintf(b, "%s", s);
+    clic_bprintf(b, "\n");
 
     // acceptable and default values
-    if (type == CLIC_STRING && param_or_arg.data.restrict_to_declared_options) {
-        printf("%*soptions: ", CLIC_PADDING_1 + CLIC_PADDING_4, "");
-        nb = 0;
-        clic_list_for(param_or_arg.data.string_options, string_option,
-            clic_string_option) {
-            printf("%s%s", nb ? ", ": "", string_option->value);
-            nb++;
-        }
-        printf("\n");
-    }
-    if (!param_or_arg.is_required && type != CLIC_FLAG) {
-        printf("%*sdefault: ", CLIC_PADDING_1 + CLIC_PADDING_4, "");
-        switch (type) {
-        case CLIC_FLAG: // unreachable
+    if (type == CLIC_STRING &&
+        param_or_arg->data.restrict_to_declared_options) {
+        clic_bprintf(b, "%*soptions: ", CLIC_PADDING_1 + CLIC_PADDING_4, "");
+        for (size_t i = 0; i < param_or_arg->data.nb_string_options; i++) {
+            clic_bprintf(b, "%s%s", i ? ", ": "",
+                param_or_arg->data.string_options[i]);
+        }
+        clic_bprintf(b, "\n");
+    }
+    if (!param_or_arg->is_required && type != CLIC_FLAG &&
+        type != CLIC_INT_LIST && type != CLIC_STRING_LIST) {
+        clic_bprintf(b, "%*sdefault: ", CLIC_PADDING_1 + CLIC_PADDING_4, "");
+        clic_write_default_value(b, param_or_arg);
+        clic_bprintf(b, "\n");
+    }
+}
+
+#if defined(CLIC_DUMP_SYNOPSIS) || defined(CLIC_DUMP_OPTIONS)
+static void
+clic_write_roff(struct clic_buffer *b, const char *s, size_t len)
+{
+    // escape s, assuming it is written at the start of a line
+    for (size_t i = 0; i < len; i++) {
+        switch (s[i]) {
+        case '-':
+            clic_bprintf(b, "\\-");
             break;
-        case CLIC_BOOL:
-            printf("--%s%s",
-                param_or_arg.data.scalar_default_value ? "" : "no-",
-                param_or_arg.name);
+        case '\\':
+            clic_bprintf(b, "\\e");
             break;
-        case CLIC_INT:
-            printf("%d", param_or_arg.data.scalar_default_value);
+        case '.':
+        case '\'':
+            clic_bprintf(b, i ? "%c" : "\\&%c", s[i]);
             break;
-        case CLIC_STRING:
-            printf("%s", param_or_arg.data.string_default_value);
+        case '\n':
+            clic_bprintf(b, " ");
+            break;
+        default:
+            clic_bprintf(b, "%c", s[i]);
             break;
         }
-        printf("\n");
     }
 }
+#endif // CLIC_DUMP_SYNOPSIS || CLIC_DUMP_OPTIONS
 
+#ifdef CLIC_DUMP_OPTIONS
 static void
-clic_print_options(void)
+clic_write_roff_param_or_arg(struct clic_buffer *b,
+    const struct clic_param_or_arg *param_or_arg)
 {
-    // TODO
-    clic_fail("printing manual sections is unsupported yet");
-    exit(EXIT_SUCCESS);
+    const char *s = param_or_arg->name;
+    enum clic_type type = param_or_arg->type;
+    struct clic_buffer default_value = {0};
+
+    // syntax
+    clic_bprintf(b, ".TP\n");
+    if (type == CLIC_FLAG) {
+        clic_bprintf(b, ".B \\-");
+        clic_write_roff(b, s, strlen(s));
+    } else if (type == CLIC_BOOL) {
+        clic_bprintf(b, ".BR \\-\\-");
+        clic_write_roff(b, s, strlen(s));
+        clic_bprintf(b, " \", \" \\-\\-no\\-");
+        clic_write_roff(b, s, strlen(s));
+    } else if (param_or_arg->is_required) {
+        clic_bprintf(b, ".I ");
+        clic_write_roff(b, s, strlen(s));
+    } else {
+        if (isalpha((unsigned char) s[0]) && !s[1]) {
+            // also accepted as -n value and -nvalue
+            clic_bprintf(b, ".BI \\-%s \" value, \" \\-\\-", s);
+        } else {
+            clic_bprintf(b, ".BI \\-\\-");
+        }
+        clic_write_roff(b, s, strlen(s));
+        clic_bprintf(b, " \" value\"");
+    }
+    clic_bprintf(b, "\n");
+
+    // type and description
+    clic_bprintf(b, "(%s)", clic_type_name(type));
+    if ((s = param_or_arg->description)) {
+        clic_bprintf(b, " ");
+        clic_write_roff(b, s, strlen(s));
+    }
+    clic_bprintf(b, "\n");
+
+    // acceptable and default values
+    if (type == CLIC_STRING &&
+        param_or_arg->data.restrict_to_declared_options) {
+        clic_bprintf(b, ".br\noptions: ");
+        for (size_t i = 0; i < param_or_arg->data.nb_string_options; i++) {
+            clic_bprintf(b, i ? ", " : "");
+            s = param_or_arg->data.string_options[i];
+            clic_write_roff(b, s, strlen(s));
+        }
+        clic_bprintf(b, "\n");
+    }
+    if (!param_or_arg->is_required && type != CLIC_FLAG &&
+        type != CLIC_INT_LIST && type != CLIC_STRING_LIST) {
+        clic_write_default_value(&default_value, param_or_arg);
+        clic_bprintf(b, ".br\ndefault: ");
+        clic_write_roff(b, default_value.data, default_value.length);
+        clic_bprintf(b, "\n");
+        free(default_value.data);
+    }
 }
+#endif // CLIC_DUMP_OPTIONS
 
+#if defined(CLIC_DUMP_BASH_COMPLETION) || defined(CLIC_DUMP_ZSH_COMPLETION)
 static void
-clic_print_synopsis(void)
+clic_write_shell_function(struct clic_buffer *b, const char *program_name)
 {
-    // TODO
-    clic_fail("printing manual sections is unsupported yet");
-    exit(EXIT_SUCCESS);
+    // name of the completion function of program_name
+    clic_bprintf(b, "_clic_");
+    for (; *program_name; program_name++) {
+        clic_bprintf(b, "%c", isalnum((unsigned char) *program_name) ?
+            *program_name : '_');
+    }
 }
+#endif // CLIC_DUMP_BASH_COMPLETION || CLIC_DUMP_ZSH_COMPLETION
 
+#ifdef CLIC_DUMP_ZSH_COMPLETION
 static void
-clic_set_flag_or_bool(int *variable, int value, int mask)
+clic_write_zsh_action(struct clic_buffer *b,
+    const struct clic_param_or_arg *param_or_arg)
 {
-    if (mask) {
-        if (value) {
-            *variable |= mask;
-        } else {
-            *variable &= ~mask;
+    // action completing the value of param_or_arg
+    if (param_or_arg->type == CLIC_STRING &&
+        param_or_arg->data.restrict_to_declared_options) {
+        clic_bprintf(b, "(");
+        for (size_t i = 0; i < param_or_arg->data.nb_string_options; i++) {
+            clic_bprintf(b, i ? " " : "");
+            clic_write_escaped(b, param_or_arg->data.string_options[i],
+                " ()\\:");
         }
+        clic_bprintf(b, ")");
+    } else if (param_or_arg->type == CLIC_STRING ||
+        param_or_arg->type == CLIC_STRING_LIST) {
+        clic_bprintf(b, "_files");
     } else {
-        *variable = value;
-    };
+        clic_bprintf(b, " ");
+    }
+}
+#endif // CLIC_DUMP_ZSH_COMPLETION
+
+#ifdef CLIC_DUMP_ZSH_COMPLETION
+static void
+clic_write_zsh_arguments(struct clic_buffer *b,
+    const struct clic_schema *schema, const struct clic_scope *scope,
+    int indent)
+{
+    // _arguments call completing scope, one specification per line
+    const struct clic_param_or_arg *param_or_arg;
+    const char *s, *description;
+    int is_list;
+
+    clic_bprintf(b, "%*s_arguments -S", indent, "");
+    for (size_t i = 0; i < scope->nb_params; i++) {
+        param_or_arg = &scope->params[i];
+        s = param_or_arg->name;
+        description = param_or_arg->description ?
+            param_or_arg->description : "";
+        clic_bprintf(b, " \\\n%*s'", indent + 4, "");
+        switch (param_or_arg->type) {
+        case CLIC_FLAG:
+            clic_bprintf(b, "-%s[", s);
+            clic_write_escaped(b, description, "[]:\\");
+            clic_bprintf(b, "]'");
+            break;
+        case CLIC_BOOL:
+            clic_bprintf(b, "(--no-%s)--%s[", s, s);
+            clic_write_escaped(b, description, "[]:\\");
+            clic_bprintf(b, "]' \\\n%*s'(--%s)--no-%s[", indent + 4, "", s,
+                s);
+            clic_write_escaped(b, description, "[]:\\");
+            clic_bprintf(b, "]'");
+            break;
+        default:
+            // one character names also take -n value and -nvalue, the two
+            // forms excluding each other unless the parameter is repeatable
+            is_list = param_or_arg->type == CLIC_INT_LIST ||
+                param_or_arg->type == CLIC_STRING_LIST;
+            for (int is_short = !s[1]; is_short >= 0; is_short--) {
+                if (is_short) {
+                    clic_bprintf(b, is_list ? "*" : "(--%s)", s);
+                    clic_bprintf(b, "-%s+[", s);
+                } else {
+                    if (!s[1]) {
+                        clic_bprintf(b, "' \\\n%*s'", indent + 4, "");
+                    }
+                    clic_bprintf(b, is_list ? "*" : s[1] ? "" : "(-%s)", s);
+                    clic_bprintf(b, "--%s=[", s);
+                }
+                clic_write_escaped(b, description, "[]:\\");
+                clic_bprintf(b, "]:%s:", clic_type_name(param_or_arg->type));
+                clic_write_zsh_action(b, param_or_arg);
+            }
+            clic_bprintf(b, "'");
+            break;
+        }
+    }
+    for (size_t i = 0; i < scope->nb_args; i++) {
+        clic_bprintf(b, " \\\n%*s'%zu:%s:", indent + 4, "", i + 1,
+            scope->args[i].name);
+        clic_write_zsh_action(b, &scope->args[i]);
+        clic_bprintf(b, "'");
+    }
+    if (!scope->subcommand_id && schema->nb_subcommands && !scope->nb_args) {
+        clic_bprintf(b, " \\\n%*s'1:subcommand:((", indent + 4, "");
+        for (size_t i = 0; i < schema->nb_subcommands; i++) {
+            description = schema->subcommands[i].description;
+            clic_bprintf(b, "%s%s\\:\"", i ? " " : "",
+                schema->subcommands[i].name);
+            clic_write_escaped(b, description ? description : "", "\"\\`$");
+            clic_bprintf(b, "\"");
+        }
+        clic_bprintf(b, "))'");
+    }
+    if (scope->accept_unnamed_arguments) {
+        clic_bprintf(b, " \\\n%*s'*:argument:_files'", indent + 4, "");
+    }
+    if (!clic_find_param_or_arg(scope, 0, "conf", 4)) {
+        clic_bprintf(b, " \\\n%*s'--conf=[read parameters from a file]"
+            ":file:_files'", indent + 4, "");
+    }
+    if (schema->metadata.version) {
+        clic_bprintf(b, " \\\n%*s'--version[print version]'", indent + 4, "");
+    }
+    clic_bprintf(b, " \\\n%*s'--help[print help]'\n", indent + 4, "");
 }
+#endif // CLIC_DUMP_ZSH_COMPLETION
 
 #endif // CLIC_IMPL
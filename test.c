@@ -0,0 +1,292 @@
+// test.c - clic.h tests
+// make check (or cc -o clic-test test.c && ./clic-test)
+//
+// Parses command lines against a static schema through a context, checking
+// the stored values, and the state, error code and token index of failures.
+// The double parser and the edit distance kernel behind suggestions are
+// compared with strtod and a plain Levenshtein distance on random inputs.
+// Prints each failed check, and exits with a failure status if there is one.
+
+#include <errno.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CLIC_IMPL
+#include "clic.h"
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+struct results {
+    int flags, color, jobs;
+    const char *format;
+    int64_t offset;
+    uint64_t count;
+    size_t size;
+    double ratio;
+    int *numbers;
+    size_t nb_numbers;
+    const char **tags;
+    size_t nb_tags;
+    const char *target;
+};
+
+static struct results prototype;
+static const char *const formats[] = { "text", "json" };
+static const struct clic_param_or_arg params[] = {
+    CLIC_PARAM_FLAG("a", "flag a", &prototype.flags, 1),
+    CLIC_PARAM_FLAG("b", "flag b", &prototype.flags, 2),
+    CLIC_PARAM_BOOL("color", "colored output", 0, &prototype.color, 0),
+    CLIC_PARAM_INT("j", "jobs", 1, &prototype.jobs),
+    CLIC_PARAM_STRING_RESTRICTED("format", "output format", "text",
+        &prototype.format, formats),
+    CLIC_PARAM_INT64("offset", "offset", 0, &prototype.offset),
+    CLIC_PARAM_UINT64("count", "count", 0, &prototype.count),
+    CLIC_PARAM_SIZE("size", "size", 0, &prototype.size),
+    CLIC_PARAM_DOUBLE("ratio", "ratio", 0.5, &prototype.ratio),
+    CLIC_PARAM_INT_LIST("n", "numbers", &prototype.numbers,
+        &prototype.nb_numbers),
+    CLIC_PARAM_STRING_LIST("tag", "tags", &prototype.tags,
+        &prototype.nb_tags),
+};
+static const struct clic_param_or_arg build_args[] = {
+    CLIC_ARG_STRING("target", "build target", &prototype.target),
+};
+static const struct clic_scope subcommands[] = {
+    { .subcommand_id = 1, .name = "build", CLIC_ARGS(build_args) },
+};
+static const struct clic_schema schema = {
+    .metadata = { .version = "1.0.0", .license = "GPLv3" },
+    .main_scope = { .name = "test", CLIC_PARAMS(params) },
+    CLIC_SUBCOMMANDS(subcommands),
+};
+
+static struct clic_ctx ctx;
+static struct results r;
+static struct clic_status status;
+static char message[256];
+static int nb_failures;
+
+static void
+check(int condition, const char *text, int line)
+{
+    if (!condition) {
+        printf("test.c:%d: %s\n", line, text);
+        nb_failures++;
+    }
+}
+
+static enum clic_state
+parse(const char *line)
+{
+    // parses a copy of line into r, after releasing its previous lists
+    static char copy[256];
+    const char *argv[32];
+
+    clic_ctx_free_results(&ctx, &r);
+    snprintf(copy, sizeof(copy), "%s", line);
+    status = (struct clic_status) {
+        .message = message,
+        .message_size = sizeof(message),
+    };
+    return clic_ctx_try_parse_line(&ctx, &r, copy, argv, CLIC_COUNT(argv),
+        &status);
+}
+
+static int
+fails(const char *line, enum clic_error_code error, int token)
+{
+    return parse(line) == CLIC_ERROR && status.error == error &&
+        status.token == token;
+}
+
+static void
+test_parse(void)
+{
+    // defaults
+    CHECK(parse("") == CLIC_PARSED);
+    CHECK(r.flags == 0 && r.color == 0 && r.jobs == 1);
+    CHECK(!strcmp(r.format, "text") && r.ratio == 0.5);
+    CHECK(!r.numbers && !r.nb_numbers && !r.tags && !r.nb_tags);
+
+    // --name=value, bools
+    CHECK(parse("--format=json --j=4 --color") == CLIC_PARSED);
+    CHECK(!strcmp(r.format, "json") && r.jobs == 4 && r.color == 1);
+    CHECK(parse("--color --no-color") == CLIC_PARSED && r.color == 0);
+    CHECK(fails("--no-j 3", CLIC_ERROR_BAD_SYNTAX, 1));
+    CHECK(fails("--color=1", CLIC_ERROR_BAD_SYNTAX, 1));
+
+    // bundled short flags and attached short values
+    CHECK(parse("-ab") == CLIC_PARSED && r.flags == 3);
+    CHECK(parse("-bj8") == CLIC_PARSED && r.flags == 2 && r.jobs == 8);
+    CHECK(parse("-a -j 9") == CLIC_PARSED && r.flags == 1 && r.jobs == 9);
+    CHECK(fails("-ax", CLIC_ERROR_UNKNOWN_PARAMETER, 1));
+    CHECK(fails("-a -j", CLIC_ERROR_MISSING_VALUE, 2));
+    CHECK(fails("--a", CLIC_ERROR_BAD_SYNTAX, 1));
+
+    // lists
+    CHECK(parse("-n1 --n 2 --n=3 -n 4 -n5 --tag x --tag=y") == CLIC_PARSED);
+    CHECK(r.nb_numbers == 5 && r.numbers[0] == 1 && r.numbers[4] == 5);
+    CHECK(r.nb_tags == 2 && !strcmp(r.tags[0], "x") &&
+        !strcmp(r.tags[1], "y"));
+    CHECK(fails("-n 1 -n x", CLIC_ERROR_INVALID_VALUE, 4));
+
+    // integers
+    CHECK(parse("--size 4k --count 0x10 --offset -2M") == CLIC_PARSED);
+    CHECK(r.size == 4096 && r.count == 16 && r.offset == -2 * 1048576);
+    CHECK(parse("--count 18446744073709551615") == CLIC_PARSED);
+    CHECK(r.count == UINT64_MAX);
+    CHECK(parse("--offset -9223372036854775808") == CLIC_PARSED);
+    CHECK(r.offset == INT64_MIN);
+    CHECK(parse("-j 2147483647") == CLIC_PARSED && r.jobs == 2147483647);
+    CHECK(fails("-j 2147483648", CLIC_ERROR_OUT_OF_RANGE, 2));
+    CHECK(fails("-j 2097152k", CLIC_ERROR_OUT_OF_RANGE, 2));
+    CHECK(fails("--count 18446744073709551616", CLIC_ERROR_OUT_OF_RANGE, 2));
+    CHECK(fails("--count 16E", CLIC_ERROR_INVALID_VALUE, 2));
+    CHECK(fails("--size -1", CLIC_ERROR_INVALID_VALUE, 2));
+    CHECK(fails("-j 12x", CLIC_ERROR_INVALID_VALUE, 2));
+    CHECK(fails("-j ''", CLIC_ERROR_INVALID_VALUE, 2));
+
+    // doubles
+    CHECK(parse("--ratio -1.5e-3") == CLIC_PARSED && r.ratio == -1.5e-3);
+    CHECK(fails("--ratio 1e400", CLIC_ERROR_OUT_OF_RANGE, 2));
+    CHECK(fails("--ratio 0x1p3", CLIC_ERROR_INVALID_VALUE, 2));
+
+    // other errors, with the index of the offending token
+    CHECK(fails("--format xml", CLIC_ERROR_INVALID_VALUE, 2));
+    CHECK(fails("--formats json", CLIC_ERROR_UNKNOWN_PARAMETER, 1));
+    CHECK(strstr(message, "did you mean '--format'") != NULL);
+    CHECK(fails("-a --j", CLIC_ERROR_MISSING_VALUE, 2));
+    CHECK(fails("build", CLIC_ERROR_MISSING_ARGUMENT, -1));
+    CHECK(fails("build all more", CLIC_ERROR_TOO_MANY_ARGUMENTS, 3));
+    CHECK(fails("-a 'unterminated", CLIC_ERROR_BAD_QUOTING, 2));
+    CHECK(parse("build all") == CLIC_PARSED && status.subcommand_id == 1);
+    CHECK(!strcmp(r.target, "all") && status.nb_processed_arguments == 2);
+    CHECK(fails("-j 2 rest", CLIC_ERROR_TOO_MANY_ARGUMENTS, 3));
+    CHECK(parse("--help") == CLIC_HELP && parse("--version") == CLIC_VERSION);
+}
+
+static int
+read_double_matches_strtod(const char *s)
+{
+    double expected, value;
+    int ret;
+
+    errno = 0;
+    expected = strtod(s, NULL);
+    ret = clic_read_double(s, &value);
+    if (isinf(expected)) {
+        return ret == CLIC_ERROR_OUT_OF_RANGE;
+    }
+    return !ret && !memcmp(&value, &expected, sizeof(value));
+}
+
+static void
+test_double(void)
+{
+    // random decimal numbers, dense around the limits and halfway cases
+    static const char *const cases[] = {
+        "0", "-0", "1.", ".5", "2.2250738585072011e-308",
+        "2.2250738585072014e-308", "4.9406564584124654e-324", "2.4703282292062327e-324",
+        "1.7976931348623157e308", "1.7976931348623159e308",
+        "9007199254740993", "0.1", "123456789012345678901234567890e-10",
+    };
+    char s[64];
+    size_t len;
+    double value;
+
+    for (size_t i = 0; i < CLIC_COUNT(cases); i++) {
+        if (!read_double_matches_strtod(cases[i])) {
+            printf("test.c: clic_read_double(\"%s\")\n", cases[i]);
+            nb_failures++;
+        }
+    }
+    srand(1);
+    for (int i = 0; i < 200000; i++) {
+        len = 0;
+        if (rand() % 2) s[len++] = '-';
+        for (int n = 1 + rand() % 20; n--;) s[len++] = '0' + rand() % 10;
+        if (rand() % 2) {
+            s[len++] = '.';
+            for (int n = rand() % 20; n--;) s[len++] = '0' + rand() % 10;
+        }
+        if (rand() % 2) {
+            len += sprintf(s + len, "e%d", rand() % 700 - 350);
+        }
+        s[len] = '\0';
+        if (!read_double_matches_strtod(s)) {
+            printf("test.c: clic_read_double(\"%s\")\n", s);
+            nb_failures++;
+        }
+    }
+    CHECK(clic_read_double(".", &value) == CLIC_ERROR_INVALID_VALUE);
+    CHECK(clic_read_double("1e", &value) == CLIC_ERROR_INVALID_VALUE);
+    CHECK(clic_read_double("inf", &value) == CLIC_ERROR_INVALID_VALUE);
+    CHECK(clic_read_double(" 1", &value) == CLIC_ERROR_INVALID_VALUE);
+}
+
+static size_t
+levenshtein(const char *a, const char *b)
+{
+    size_t m = strlen(a), n = strlen(b), d[16][16];
+
+    for (size_t i = 0; i <= m; i++) {
+        for (size_t j = 0; j <= n; j++) {
+            if (!i || !j) {
+                d[i][j] = i + j;
+                continue;
+            }
+            d[i][j] = d[i - 1][j - 1] + (a[i - 1] != b[j - 1]);
+            if (d[i - 1][j] + 1 < d[i][j]) d[i][j] = d[i - 1][j] + 1;
+            if (d[i][j - 1] + 1 < d[i][j]) d[i][j] = d[i][j - 1] + 1;
+        }
+    }
+    return d[m][n];
+}
+
+static void
+test_edit_distance(void)
+{
+    // small alphabets, so that names share characters
+    struct clic_nearest nearest;
+    char a[16], b[16];
+    size_t m, n;
+
+    srand(2);
+    for (int i = 0; i < 200000; i++) {
+        m = rand() % 15;
+        n = rand() % 15;
+        for (size_t j = 0; j < m; j++) a[j] = 'a' + rand() % 4;
+        for (size_t j = 0; j < n; j++) b[j] = 'a' + rand() % 4;
+        a[m] = b[n] = '\0';
+        clic_nearest_init(&nearest, a, m);
+        nearest.distance = SIZE_MAX;
+        clic_nearest_add(&nearest, b);
+        if (nearest.distance != levenshtein(a, b)) {
+            printf("test.c: distance(\"%s\", \"%s\") = %zu, expected %zu\n",
+                a, b, nearest.distance, levenshtein(a, b));
+            nb_failures++;
+        }
+    }
+}
+
+int
+main(void)
+{
+    clic_check_schema(&schema);
+    clic_ctx_init(&ctx, &schema);
+    clic_ctx_set_results(&ctx, &prototype, sizeof(prototype));
+
+    test_parse();
+    test_double();
+    test_edit_distance();
+
+    clic_ctx_free_results(&ctx, &r);
+    clic_ctx_free(&ctx);
+    printf("%s (%d failed checks)\n", nb_failures ? "FAIL" : "ok",
+        nb_failures);
+    return nb_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}